@@ -0,0 +1,20 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdint.h>
+
+// The bootloader runs from the PLL at the LM3S6965's top rated 50 MHz, from
+// the 8 MHz crystal on the evaluation board (1), or stays on the clock it
+// was reset with (0), e.g. make CLOCK_PLL=0 to compare update times
+#ifndef CLOCK_PLL
+#define CLOCK_PLL 1
+#endif
+
+void clock_init(void);
+void clock_restore(void);
+uint32_t clock_reset_hz(void);
+
+#endif
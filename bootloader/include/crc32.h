@@ -0,0 +1,15 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+
+// CRC-32 as used by zlib (reflected polynomial 0xEDB88320). Start with 0 and
+// pass each result back in to continue, like Python's zlib.crc32.
+#define CRC32_SIZE 4
+
+uint32_t crc32_update(uint32_t crc, const void *data, uint32_t len);
+
+#endif
@@ -0,0 +1,33 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+#ifndef FLASH_ENGINE_H
+#define FLASH_ENGINE_H
+
+#include <stdint.h>
+
+// Flash erases and programs run as queued jobs, advanced one operation at a
+// time by the flash controller's completion interrupt, so the CPU is free
+// while the flash is busy. Jobs run in the order they were submitted. Once
+// the engine is running, nothing may call FlashErase() or FlashProgram().
+// Must be a power of two.
+#define FLASH_QUEUE_SIZE 16
+
+// Let flash jobs run on while the next page is received (1), or wait for
+// each page to be written before going on (0), e.g. make FLASH_OVERLAP=0
+#ifndef FLASH_OVERLAP
+#define FLASH_OVERLAP 1
+#endif
+
+void flash_engine_init(void);
+void flash_engine_disable(void);
+int flash_submit_erase(uint32_t page_addr);
+int flash_submit_program(uint32_t addr, const uint32_t *data, uint32_t words);
+uint32_t flash_poll(void);
+uint32_t flash_jobs_submitted(void);
+uint32_t flash_jobs_done(void);
+int flash_wait(void);
+int flash_erase_sync(uint32_t page_addr);
+int flash_program_sync(uint32_t addr, const uint32_t *data, uint32_t words);
+
+#endif
@@ -0,0 +1,26 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+#ifndef FLASH_LAYOUT_H
+#define FLASH_LAYOUT_H
+
+// Firmware Constants
+#define METADATA_SPARE_BASE 0xF400 // second page of the metadata log (see metadata.c)
+#define JOURNAL_BASE 0xF800        // base address of the update progress journal
+#define METADATA_BASE 0xFC00       // base address of version and firmware size in Flash
+#define FW_BASE 0x10000            // base address of firmware in Flash
+#define FLASH_END 0x40000          // end of the 256 KB flash
+
+// Firmware Slots
+// Images are linked for the slot they run from (see firmware/firmware.ld).
+#define SLOT_COUNT 2
+#define SLOT_SIZE 0x10000    // a 16-bit size field limits images to 64 KB
+#define SLOT_A 0
+#define SLOT_B 1
+#define SLOT_BASE(slot) (FW_BASE + (slot) * SLOT_SIZE)
+
+// FLASH Constants
+#define FLASH_PAGESIZE 1024
+#define FLASH_WRITESIZE 4
+
+#endif
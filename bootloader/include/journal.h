@@ -0,0 +1,15 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+
+// Flash-resident record of how far an update has been committed, so an
+// interrupted transfer can pick up where it left off.
+uint32_t journal_resume(uint32_t image_id, uint32_t metadata);
+int journal_append(uint32_t page_index);
+void journal_close(void);
+
+#endif
@@ -0,0 +1,53 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+
+// Buffered debug log on UART2. Messages are queued in a ring that the UART2
+// transmit interrupt drains, so logging never waits for the line. A message
+// that does not fit is dropped whole and counted.
+#define LOG_TX_BUFFER_SIZE 1024 // must be a power of two
+
+// Levels, most severe first. A message is kept if its level is at or below
+// both LOG_LEVEL (compile time) and the runtime level.
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1 // written synchronously, after anything queued
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// Messages above this level are compiled out, e.g. make LOG_LEVEL=2
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#define LOG(level, str)                                                        \
+    do {                                                                       \
+        if ((level) <= LOG_LEVEL) log_str((level), (str));                     \
+    } while (0)
+
+// Logs str followed by value in hex and a newline
+#define LOG_VALUE(level, str, value)                                           \
+    do {                                                                       \
+        if ((level) <= LOG_LEVEL) log_value((level), (str), (value));          \
+    } while (0)
+
+#define LOG_HEX_BYTES(level, data, len)                                        \
+    do {                                                                       \
+        if ((level) <= LOG_LEVEL) log_hex_bytes((level), (data), (len));       \
+    } while (0)
+
+void log_init(void);
+void log_disable(void);
+void log_set_level(uint8_t level);
+uint8_t log_level(void);
+void log_str(uint8_t level, const char *str);
+void log_value(uint8_t level, const char *str, uint32_t value);
+void log_hex_bytes(uint8_t level, const uint8_t *data, uint32_t len);
+void log_flush(void);
+uint32_t log_dropped(void);
+
+#endif
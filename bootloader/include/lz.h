@@ -0,0 +1,26 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+#ifndef LZ_H
+#define LZ_H
+
+#include <stdint.h>
+
+// Streaming LZSS decoder for images packed by tools/lz.py.
+#define LZ_WINDOW_SIZE 1024 // history needed to resolve matches
+#define LZ_MIN_MATCH 3
+#define LZ_MAX_MATCH (LZ_MIN_MATCH + 63)
+
+typedef struct {
+    uint8_t window[LZ_WINDOW_SIZE];
+    uint32_t pos;      // bytes produced so far
+    uint8_t flags;     // flag byte of the current group
+    uint8_t items;     // items left in the current group
+    uint8_t state;
+    uint8_t token_lo;  // first byte of a match token
+} lz_state_t;
+
+void lz_init(lz_state_t *lz);
+int lz_decode_byte(lz_state_t *lz, uint8_t in, uint8_t *out);
+
+#endif
@@ -0,0 +1,26 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <stdint.h>
+
+// Static memory plan (see bootloader.ld)
+// Large buffers are neither put on the stack nor left wherever they fall in
+// .bss: they are declared with ARENA, which gathers them at the start of
+// .bss in the BOOT_ARENA_SIZE bytes the linker script sets aside, and the
+// link fails if they outgrow it. Like the rest of .bss they start zeroed.
+#define ARENA __attribute__((section(".bss.arena")))
+
+// The whole stack is filled with this at reset (see startup_gcc.c). The
+// lowest word that no longer holds it marks the deepest the stack has been.
+#define STACK_PAINT 0xDEADBEEF
+
+uint32_t stack_size(void);
+uint32_t stack_high_water(void);
+uint32_t arena_size(void);
+uint32_t arena_used(void);
+void memory_report(void);
+
+#endif
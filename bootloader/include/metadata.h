@@ -0,0 +1,39 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+#ifndef METADATA_H
+#define METADATA_H
+
+#include <stdint.h>
+
+#include "flash_layout.h"
+
+// Device metadata
+// One word per slot holding the version (low half) and size (high half) of
+// the image it contains, a word of the digest it was installed with, and the
+// slot to boot. Without any metadata every word reads as erased, and an
+// erased selector means A.
+//
+// Only the first word of the digest is kept. The whole digest was already
+// checked against the committed image before the metadata is written, so the
+// word does not vouch for the image; it only tells apart which image a slot
+// holds, and keeps a log record to 36 bytes (a full SHA-256 would leave 11
+// records to a page instead of 28).
+typedef struct {
+    uint32_t slot[SLOT_COUNT];
+    uint32_t digest_word[SLOT_COUNT]; // first word of the image digest, little endian
+    uint8_t digest_type[SLOT_COUNT];  // image flag of the digest kind, 0 if none
+    uint16_t reserved;
+    uint32_t active;
+} metadata_t;
+
+#define SLOT_EMPTY 0xFFFFFFFF   // slot never written
+#define SLOT_INVALID 0x00000000 // slot being written, or left incomplete
+
+// The current metadata, as of the last metadata_init() or metadata_write()
+extern const metadata_t * const metadata;
+
+void metadata_init(void);
+int metadata_write(const metadata_t *m);
+
+#endif
@@ -0,0 +1,40 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+#include "flash_layout.h"
+
+// Cycle profile of an update, taken from SysTick. Time is charged to one
+// phase at a time: profile_enter() closes the running phase and opens the
+// next, so the phases add up to the whole update. Flash work is also totalled
+// per page of the slot being written. Counts are in cycles of the current
+// system clock (see profile_clock()).
+#define PROFILE_RECEIVE 0 // waiting for, decoding and assembling host data
+#define PROFILE_COMPARE 1 // checking a page against flash before writing it
+#define PROFILE_ERASE 2   // waiting for the flash jobs of a page with an erase
+#define PROFILE_PROGRAM 3 // waiting for the flash jobs of a page without one
+#define PROFILE_VERIFY 4  // reading a page back: compare or image digest
+#define PROFILE_OTHER 5   // metadata, journal and delta page digests
+#define PROFILE_PHASES 6
+#define PROFILE_NONE 0xFF // not profiling
+
+#define PROFILE_MAX_PAGES (SLOT_SIZE / FLASH_PAGESIZE)
+
+void profile_init(void);
+void profile_disable(void);
+void profile_start(uint8_t phase);
+void profile_end(void);
+uint8_t profile_enter(uint8_t phase);
+uint64_t profile_cycles(void);
+uint64_t profile_scale(uint64_t cycles, uint32_t from_hz, uint32_t to_hz);
+void profile_clock(uint32_t from_hz, uint32_t to_hz);
+void profile_page(uint32_t page_addr, uint32_t cycles);
+uint64_t profile_phase_cycles(uint8_t phase);
+uint32_t profile_page_cycles(uint32_t page);
+uint32_t profile_pages(void);
+
+#endif
@@ -0,0 +1,53 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stdint.h>
+
+/*
+ * Single-producer, single-consumer byte ring shared between an interrupt
+ * handler and the main loop. The size must be a power of two. One side only
+ * ever writes head and the other only ever writes tail, so no locking is
+ * needed as long as each index is updated after the data it covers.
+ */
+typedef struct {
+    uint8_t *buf;
+    uint32_t mask;
+    volatile uint32_t head; // next slot to write
+    volatile uint32_t tail; // next slot to read
+} ring_buffer_t;
+
+#define RING_INIT(storage) { (storage), sizeof(storage) - 1, 0, 0 }
+
+static inline uint32_t ring_count(const ring_buffer_t *r){
+    return (r->head - r->tail) & r->mask;
+}
+
+static inline uint32_t ring_space(const ring_buffer_t *r){
+    return r->mask - ring_count(r);
+}
+
+static inline int ring_put(ring_buffer_t *r, uint8_t c){
+    uint32_t head = r->head;
+    uint32_t next = (head + 1) & r->mask;
+    if (next == r->tail){
+        return -1; // full
+    }
+    r->buf[head] = c;
+    r->head = next;
+    return 0;
+}
+
+static inline int ring_get(ring_buffer_t *r, uint8_t *c){
+    uint32_t tail = r->tail;
+    if (tail == r->head){
+        return -1; // empty
+    }
+    *c = r->buf[tail];
+    r->tail = (tail + 1) & r->mask;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,26 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+#ifndef UART_RX_H
+#define UART_RX_H
+
+#include <stdint.h>
+
+// Interrupt-fed receive buffer for the host connection (UART1).
+// Must be a power of two and hold every byte the host may have in flight.
+#define UART_RX_BUFFER_SIZE 4096
+
+// Rate uart_init() configures and the host expects after a reset
+#define UART_DEFAULT_BAUD 115200
+
+void uart_rx_init(void);
+void uart_rx_disable(void);
+uint8_t uart_rx_getc(void);
+int uart_rx_getc_timeout(uint8_t *c, uint32_t timeout_ms);
+void uart_rx_drain(uint32_t idle_ms);
+uint32_t uart_rx_available(void);
+uint32_t uart_rx_overruns(void);
+int uart_rx_set_baud(uint32_t baud);
+uint32_t uart_rx_baud(void);
+
+#endif
@@ -6,6 +6,7 @@
 #include "inc/lm3s6965.h"  // Peripheral Bit Masks and Registers
 #include "inc/hw_types.h"  // Boolean type
 #include "inc/hw_ints.h"   // Interrupt numbers
+#include "inc/hw_nvic.h"   // NVIC registers (vector table offset)
 
 // Driver API Imports
 #include "driverlib/flash.h"     // FLASH API
@@ -14,48 +15,179 @@
 
 // Library Imports
 #include <string.h>
+#include "bearssl_hash.h"
+#include "crc32.h"
 
 // Application Imports
+#include "clock.h"
+#include "flash_engine.h"
+#include "flash_layout.h"
+#include "journal.h"
+#include "log.h"
+#include "lz.h"
+#include "memory.h"
+#include "metadata.h"
+#include "profile.h"
 #include "uart.h"
+#include "uart_rx.h"
 
 // Forward Declarations
 void load_initial_firmware(void);
 void load_firmware(void);
+void load_firmware_v2(void);
+void load_firmware_delta(void);
 void boot_firmware(void);
-long program_flash(uint32_t, unsigned char *, unsigned int);
+void submit_page(uint32_t, unsigned char *, unsigned int);
+void report_flash_stats(void);
+int receive_metadata(uint32_t, uint32_t *, uint32_t *);
+int commit_metadata(uint32_t, uint32_t, uint32_t);
+int slot_good(uint32_t);
+int boot_slot(void);
+uint32_t update_slot(void);
+uint32_t image_limit(uint32_t, uint32_t);
+void rollback(void);
+void set_baud(void);
+void set_log_level(void);
+void restore_baud(void);
+int commit_page(uint32_t, unsigned char *, uint32_t, int32_t);
+int commit_wait(void);
+void reject_frame(uint8_t);
+void send_profile(void);
 
-// Firmware Constants
-#define METADATA_BASE 0xFC00 // base address of version and firmware size in Flash
-#define FW_BASE 0x10000      // base address of firmware in Flash
+// Digest of a whole image, built up from flash as its pages are committed
+// and checked against the one sent with the image.
+typedef struct {
+    uint8_t type;                // IMAGE_FLAG_CRC32, IMAGE_FLAG_SHA256 or 0
+    uint32_t crc;
+    br_sha256_context sha;
+    uint8_t expected[br_sha256_SIZE];
+} image_digest_t;
 
-// FLASH Constants
-#define FLASH_PAGESIZE 1024
-#define FLASH_WRITESIZE 4
+void digest_init(image_digest_t *, uint8_t);
+uint32_t digest_size(const image_digest_t *);
+void digest_update(image_digest_t *, const void *, uint32_t);
+int digest_check(image_digest_t *);
+
+// Assembles a stream of image bytes into pages and commits each one as it
+// fills, alternating between the two page buffers.
+typedef struct {
+    uint32_t image_base;  // flash address of the start of the image
+    uint32_t page_addr;   // flash address of the page being assembled
+    uint32_t index;       // bytes in the page being assembled
+    int cur;              // page buffer being assembled
+    unsigned char *ready; // completed page waiting to be committed
+    uint32_t ready_addr;
+    uint32_t limit;       // flash address the image must end by
+    int journal;          // record committed pages in the progress journal
+} page_writer_t;
+
+void writer_init(page_writer_t *, uint32_t, uint32_t, uint32_t, int);
+int writer_put(page_writer_t *, unsigned char);
+int writer_commit_ready(page_writer_t *);
+int writer_finish(page_writer_t *);
 
 // Protocol Constants
 #define OK ((unsigned char)0x00)
 #define ERROR ((unsigned char)0x01)
 #define UPDATE ((unsigned char)'U')
+#define UPDATE_V2 ((unsigned char)'V')
+#define UPDATE_DELTA ((unsigned char)'D')
+#define ROLLBACK ((unsigned char)'R')
+#define SET_BAUD ((unsigned char)'S')
+#define SET_LOG_LEVEL ((unsigned char)'L')
+#define PROFILE ((unsigned char)'P')
 #define BOOT ((unsigned char)'B')
 
+// Windowed (v2) Protocol Constants
+#define PROTOCOL_VERSION 2
+#define FRAME_HEADER_SIZE 3           // sequence number and length
+#define MAX_FRAME_SIZE FLASH_PAGESIZE // largest data section of a v2 frame
+// Frames the host may have in flight. Frames are only acknowledged once they
+// have left the receive ring, so a full window always fits in the ring.
+#define MAX_WINDOW (UART_RX_BUFFER_SIZE / (MAX_FRAME_SIZE + FRAME_HEADER_SIZE))
+
+// Quiet time on UART1 before resetting after a rejected frame
+#define REJECT_IDLE_MS 200
+
+// Image flags sent after the v2 metadata
+#define IMAGE_FLAG_LZ 0x01     // data is an LZSS stream (see lz.h)
+#define IMAGE_FLAG_SLOT_B 0x02 // image is linked for slot B rather than A
+#define IMAGE_FLAG_CRC32 0x04  // a CRC-32 of the image follows the identity
+#define IMAGE_FLAG_SHA256 0x08 // a SHA-256 of the image follows the identity
+#define IMAGE_FLAGS (IMAGE_FLAG_LZ | IMAGE_FLAG_SLOT_B | IMAGE_FLAG_CRC32 | IMAGE_FLAG_SHA256)
+
+// Baud Rate Negotiation Constants
+#define BAUD_CONFIRM "SYNC"      // sent by the host once it has switched
+#define BAUD_CONFIRM_MS 500      // longest gap allowed while waiting for it
+#define BAUD_CONFIRM_MAX_BYTES 64
+
+// Delta Protocol Constants
+#define PAGE_DIGEST_SIZE 32     // SHA-256 of a full flash page
+#define END_OF_PAGES 0xFFFF     // page index that ends a delta transfer
+
+// Longest release message, with its terminating NUL, that may follow the
+// firmware in an image (see tools/fw_protect.py)
+#define MAX_MESSAGE_SIZE FLASH_PAGESIZE
+
 // Firmware v2 is embedded in bootloader
 // Read up on these symbols in the objcopy man page (if you want)!
 extern int _binary_firmware_bin_start;
 extern int _binary_firmware_bin_size;
 
-// Device metadata
-uint16_t *fw_version_address = (uint16_t *)METADATA_BASE;
-uint16_t *fw_size_address = (uint16_t *)(METADATA_BASE + 2);
 uint8_t *fw_release_message_address;
-void uart_write_hex_bytes(uint8_t uart, uint8_t * start, uint32_t len);
 
-// Firmware Buffer
-unsigned char data[FLASH_PAGESIZE];
+// Flash statistics for the current update, counted in pages
+struct {
+    uint32_t erased;     // pages that needed an erase
+    uint32_t programmed; // pages with at least one word written
+    uint32_t skipped;    // pages that already held the target contents
+} flash_stats;
+
+// Word-aligned copies of the pages being programmed, padded with 0xFF. The
+// flash engine programs straight from them, so the next page is prepared in
+// the other one while the last is still being written.
+uint32_t flash_target[2][FLASH_PAGESIZE / FLASH_WRITESIZE] ARENA;
+uint32_t flash_target_jobs[2]; // jobs that must finish before reusing each
+int flash_target_cur;
+
+// The page committed last, finished and checked by commit_wait()
+struct {
+    uint32_t addr;          // 0 when there is none
+    uint32_t len;
+    const uint32_t *target; // what was programmed
+    int32_t journal;        // page index to record in the journal, or -1
+    int erase;              // the page needed an erase
+    uint32_t cycles;        // spent on the page so far
+} pending_page;
+
+// Firmware Buffers
+// Two page buffers so the next page can be assembled while the previous one
+// is being programmed.
+unsigned char page_buf[2][FLASH_PAGESIZE] ARENA;
+
+// Decompressor state for compressed v2 images, and the bytes decoded from
+// one input byte
+lz_state_t lz ARENA;
+uint8_t lz_out[LZ_MAX_MATCH] ARENA;
+
+// Digest of the image being installed; type 0 when the update carries none
+image_digest_t image_digest ARENA;
+
+// Hash of one page of the update slot, for the delta page digests
+br_sha256_context page_sha ARENA;
+unsigned char page_digest[PAGE_DIGEST_SIZE] ARENA;
 
 int main(void){
 
     // A 'reset' on UART0 will re-start this code at the top of main, won't clear flash, but will clean ram.
 
+    // Count cycles for the update profile and the firmware's boot time
+    profile_init();
+
+    // Run from the PLL; everything below takes its rates from this clock
+    clock_init();
+    profile_clock(clock_reset_hz(), SysCtlClockGet());
+
     // Initialize UART channels
     // 0: Reset
     // 1: Host Connection
@@ -64,24 +196,70 @@ int main(void){
     uart_init(UART1);
     uart_init(UART2);
 
+    // Receive from the host through the interrupt-fed ring buffer
+    uart_rx_init();
+
+    // Find the current metadata record
+    metadata_init();
+
+    // Erase and program flash from the flash controller interrupt
+    flash_engine_init();
+
+    // Queue debug output for the UART2 transmit interrupt
+    log_init();
+
     // Enable UART0 interrupt
     IntEnable(INT_UART0);
     IntMasterEnable();
 
     load_initial_firmware(); // note the short-circuit behavior in this function, it doesn't finish running on reset!
 
-    uart_write_str(UART2, "Welcome to the BWSI Vehicle Update Service!\n");
-    uart_write_str(UART2, "Send \"U\" to update, and \"B\" to run the firmware.\n");
-    uart_write_str(UART2, "Writing 0x20 to UART0 will reset the device.\n");
+    LOG(LOG_LEVEL_INFO, "Welcome to the BWSI Vehicle Update Service!\n");
+    LOG(LOG_LEVEL_INFO, "Send \"U\" to update, and \"B\" to run the firmware.\n");
+    LOG(LOG_LEVEL_INFO, "Send \"R\" to switch back to the other firmware slot.\n");
+    LOG(LOG_LEVEL_INFO, "Writing 0x20 to UART0 will reset the device.\n");
 
-    int resp;
     while (1){
-        uint32_t instruction = uart_read(UART1, BLOCKING, &resp);
+        uint32_t instruction = uart_rx_getc();
         if (instruction == UPDATE){
             uart_write_str(UART1, "U");
+            profile_start(PROFILE_RECEIVE);
             load_firmware();
-            uart_write_str(UART2, "Loaded new firmware.\n");
-            nl(UART2);
+            profile_end();
+            restore_baud();
+            report_flash_stats();
+            memory_report();
+            LOG(LOG_LEVEL_INFO, "Loaded new firmware.\n\n");
+        }else if (instruction == UPDATE_V2){
+            uart_write_str(UART1, "V");
+            profile_start(PROFILE_RECEIVE);
+            load_firmware_v2();
+            profile_end();
+            restore_baud();
+            report_flash_stats();
+            memory_report();
+            LOG(LOG_LEVEL_INFO, "Loaded new firmware.\n\n");
+        }else if (instruction == UPDATE_DELTA){
+            uart_write_str(UART1, "D");
+            profile_start(PROFILE_RECEIVE);
+            load_firmware_delta();
+            profile_end();
+            restore_baud();
+            report_flash_stats();
+            memory_report();
+            LOG(LOG_LEVEL_INFO, "Loaded new firmware.\n\n");
+        }else if (instruction == SET_LOG_LEVEL){
+            uart_write_str(UART1, "L");
+            set_log_level();
+        }else if (instruction == SET_BAUD){
+            uart_write_str(UART1, "S");
+            set_baud();
+        }else if (instruction == PROFILE){
+            uart_write_str(UART1, "P");
+            send_profile();
+        }else if (instruction == ROLLBACK){
+            uart_write_str(UART1, "R");
+            rollback();
         }else if (instruction == BOOT){
             uart_write_str(UART1, "B");
             boot_firmware();
@@ -94,7 +272,8 @@ int main(void){
  */
 void load_initial_firmware(void){
 
-    if (*((uint32_t *)(METADATA_BASE)) != 0xFFFFFFFF){
+    if (metadata->slot[SLOT_A] != SLOT_EMPTY || metadata->slot[SLOT_B] != SLOT_EMPTY ||
+        metadata->active != SLOT_EMPTY){
         /*
          * Default Flash startup state is all FF since. Only load initial
          * firmware when metadata page is all FF. Thus, exit if there has
@@ -103,8 +282,8 @@ void load_initial_firmware(void){
         return;
     }
 
-    // Create buffers for saving the release message
-    uint8_t temp_buf[FLASH_PAGESIZE];
+    // The last page is assembled in a page buffer, free before any update
+    uint8_t *last_page = page_buf[0];
     char initial_msg[] = "This is the initial release message.";
     uint16_t msg_len = strlen(initial_msg) + 1;
     uint16_t rem_msg_bytes;
@@ -113,15 +292,16 @@ void load_initial_firmware(void){
     int size = (int)&_binary_firmware_bin_size;
     uint8_t *initial_data = (uint8_t *)&_binary_firmware_bin_start;
 
-    // Set version 2 and install
+    // Nothing installed yet, so no earlier progress can apply
+    journal_close();
+
+    // Set version 2 and install into slot A
     uint16_t version = 2;
-    uint32_t metadata = (((uint16_t)size & 0xFFFF) << 16) | (version & 0xFFFF);
-    program_flash(METADATA_BASE, (uint8_t *)(&metadata), 4);
 
     int i;
 
     for (i = 0; i < size / FLASH_PAGESIZE; i++){
-        program_flash(FW_BASE + (i * FLASH_PAGESIZE), initial_data + (i * FLASH_PAGESIZE), FLASH_PAGESIZE);
+        submit_page(FW_BASE + (i * FLASH_PAGESIZE), initial_data + (i * FLASH_PAGESIZE), FLASH_PAGESIZE);
     }
 
     /* At end of firmware. Since the last page may be incomplete, we copy the initial
@@ -132,7 +312,7 @@ void load_initial_firmware(void){
     uint16_t rem_fw_bytes = size % FLASH_PAGESIZE;
     if (rem_fw_bytes == 0){
         // No firmware left. Just write the release message
-        program_flash(FW_BASE + (i * FLASH_PAGESIZE), (uint8_t *)initial_msg, msg_len);
+        submit_page(FW_BASE + (i * FLASH_PAGESIZE), (uint8_t *)initial_msg, msg_len);
     }else{
         // Some firmware left. Determine how many bytes of release message can fit
         if (msg_len > (FLASH_PAGESIZE - rem_fw_bytes)){
@@ -142,61 +322,159 @@ void load_initial_firmware(void){
         }
 
         // Copy rest of firmware
-        memcpy(temp_buf, initial_data + (i * FLASH_PAGESIZE), rem_fw_bytes);
+        memcpy(last_page, initial_data + (i * FLASH_PAGESIZE), rem_fw_bytes);
         // Copy what will fit of the release message
-        memcpy(temp_buf + rem_fw_bytes, initial_msg, msg_len - rem_msg_bytes);
+        memcpy(last_page + rem_fw_bytes, initial_msg, msg_len - rem_msg_bytes);
         // Program the final firmware and first part of the release message
-        program_flash(FW_BASE + (i * FLASH_PAGESIZE), temp_buf, rem_fw_bytes + (msg_len - rem_msg_bytes));
+        submit_page(FW_BASE + (i * FLASH_PAGESIZE), last_page, rem_fw_bytes + (msg_len - rem_msg_bytes));
 
         // If there are more bytes, program them directly from the release message string
         if (rem_msg_bytes > 0){
             // Writing to a new page. Increment pointer
             i++;
-            program_flash(FW_BASE + (i * FLASH_PAGESIZE), (uint8_t *)(initial_msg + (msg_len - rem_msg_bytes)), rem_msg_bytes);
+            submit_page(FW_BASE + (i * FLASH_PAGESIZE), (uint8_t *)(initial_msg + (msg_len - rem_msg_bytes)), rem_msg_bytes);
         }
     }
+
+    // Only now mark slot A as holding a good image, once it is all written.
+    // If that failed, the empty metadata makes the next reset try again.
+    if (flash_wait()){
+        LOG(LOG_LEVEL_ERROR, "Initial firmware program failed.\n");
+        return;
+    }
+    commit_metadata(SLOT_A, version, size);
 }
 
 /*
- * Load the firmware into flash.
+ * A slot is good once an image has been completely written to it.
  */
-void load_firmware(void){
-    int frame_length = 0;
-    int read = 0;
-    uint32_t rcv = 0;
+int slot_good(uint32_t slot){
+    return metadata->slot[slot] != SLOT_EMPTY && metadata->slot[slot] != SLOT_INVALID;
+}
 
-    uint32_t data_index = 0;
-    uint32_t page_addr = FW_BASE;
+/*
+ * The slot to run: the active one if it is good, otherwise the other one.
+ * Returns -1 if neither slot holds a good image.
+ */
+int boot_slot(void){
+    uint32_t active = (metadata->active == SLOT_B) ? SLOT_B : SLOT_A;
+
+    if (slot_good(active)){
+        return active;
+    }
+    if (slot_good(active ^ 1)){
+        return active ^ 1;
+    }
+    return -1;
+}
+
+/*
+ * The slot an update is written to: whichever one is not being booted, so
+ * the running image stays intact until the new one is complete.
+ */
+uint32_t update_slot(void){
+    int slot = boot_slot();
+    return (slot < 0) ? SLOT_A : (uint32_t)(slot ^ 1);
+}
+
+/*
+ * Flash address an image of size bytes of firmware, followed by its release
+ * message, must end by in slot. Nothing at or past it may be written.
+ */
+uint32_t image_limit(uint32_t slot, uint32_t size){
+    uint32_t len = size + MAX_MESSAGE_SIZE;
+    return SLOT_BASE(slot) + ((len < SLOT_SIZE) ? len : SLOT_SIZE);
+}
+
+/*
+ * Record a completely written image in its slot, with the digest it was
+ * checked against if the update carried one, and make it the one to boot.
+ * Returns 0 on success and -1 if the metadata could not be written.
+ */
+int commit_metadata(uint32_t slot, uint32_t version, uint32_t size){
+    metadata_t m = *metadata;
+
+    // Create 32 bit word for flash programming, version is at lower address, size is at higher address
+    m.slot[slot] = ((size & 0xFFFF) << 16) | (version & 0xFFFF);
+    m.digest_word[slot] = 0;
+    m.digest_type[slot] = image_digest.type;
+    if (image_digest.type != 0){
+        memcpy(&m.digest_word[slot], image_digest.expected, sizeof(m.digest_word[slot]));
+    }
+    m.active = slot;
+
+    uint8_t phase = profile_enter(PROFILE_OTHER);
+    if (metadata_write(&m)){
+        LOG(LOG_LEVEL_ERROR, "Metadata write failed.\n");
+        return -1;
+    }
+    profile_enter(phase);
+    return 0;
+}
+
+/*
+ * Switch back to the other slot if it holds a good image. This is a single
+ * metadata write; no firmware is transferred.
+ */
+void rollback(void){
+    int slot = boot_slot();
+    metadata_t m = *metadata;
+
+    if (slot < 0 || !slot_good(slot ^ 1)){
+        LOG(LOG_LEVEL_WARN, "No other firmware to roll back to.\n");
+        uart_write(UART1, ERROR);
+        return;
+    }
+
+    // Interrupted updates may not be resumed into the slot that now boots
+    journal_close();
+
+    m.active = slot ^ 1;
+    if (metadata_write(&m)){
+        LOG(LOG_LEVEL_ERROR, "Metadata write failed.\n");
+        uart_write(UART1, ERROR);
+        return;
+    }
+
+    LOG_VALUE(LOG_LEVEL_INFO, "Rolled back to slot ", m.active);
+    uart_write(UART1, OK);
+}
+
+/*
+ * Receive the version and size of an incoming image and check the version
+ * against the running one. The target slot is then marked invalid, since its
+ * contents are about to be replaced; commit_metadata() records the new image
+ * once it is complete. Returns 0 on success and -1 if the image must be
+ * rejected.
+ */
+int receive_metadata(uint32_t slot, uint32_t *version_out, uint32_t *size_out){
+    uint32_t rcv = 0;
     uint32_t version = 0;
     uint32_t size = 0;
 
     // Get version as 16 bytes 
-    rcv = uart_read(UART1, BLOCKING, &read);
+    rcv = uart_rx_getc();
     version = (uint32_t)rcv;
-    rcv = uart_read(UART1, BLOCKING, &read);
+    rcv = uart_rx_getc();
     version |= (uint32_t)rcv << 8;
 
-    uart_write_str(UART2, "Received Firmware Version: ");
-    uart_write_hex(UART2, version);
-    nl(UART2);
+    LOG_VALUE(LOG_LEVEL_INFO, "Received Firmware Version: ", version);
 
     // Get size as 16 bytes 
-    rcv = uart_read(UART1, BLOCKING, &read);
+    rcv = uart_rx_getc();
     size = (uint32_t)rcv;
-    rcv = uart_read(UART1, BLOCKING, &read);
+    rcv = uart_rx_getc();
     size |= (uint32_t)rcv << 8;
 
-    uart_write_str(UART2, "Received Firmware Size: ");
-    uart_write_hex(UART2, size);
-    nl(UART2);
+    LOG_VALUE(LOG_LEVEL_INFO, "Received Firmware Size: ", size);
 
     // Compare to old version and abort if older (note special case for version 0).
-    uint16_t old_version = *fw_version_address;
+    int running = boot_slot();
+    uint16_t old_version = (running < 0) ? 0 : (metadata->slot[running] & 0xFFFF);
 
     if (version != 0 && version < old_version){
-        uart_write(UART1, ERROR); // Reject the metadata.
-        SysCtlReset();            // Reset device
-        return;
+        LOG(LOG_LEVEL_ERROR, "Firmware version is older than the running one.\n");
+        return -1;
     }
 
     if (version == 0){
@@ -204,10 +482,258 @@ void load_firmware(void){
         version = old_version;
     }
 
-    // Write new firmware size and version to Flash
-    // Create 32 bit word for flash programming, version is at lower address, size is at higher address
-    uint32_t metadata = ((size & 0xFFFF) << 16) | (version & 0xFFFF);
-    program_flash(METADATA_BASE, (uint8_t *)(&metadata), 4);
+    // Count flash work from here to the end of the update
+    memset(&flash_stats, 0, sizeof(flash_stats));
+
+    // Pages are checked individually unless the update supplies a digest
+    digest_init(&image_digest, 0);
+
+    // Invalidate the target slot
+    if (metadata->slot[slot] != SLOT_INVALID){
+        metadata_t m = *metadata;
+        m.slot[slot] = SLOT_INVALID;
+        if (metadata_write(&m)){
+            LOG(LOG_LEVEL_ERROR, "Metadata write failed.\n");
+            return -1;
+        }
+    }
+
+    *version_out = version;
+    *size_out = size;
+    return 0;
+}
+
+/*
+ * Start programming one page buffer into flash. The page committed before it
+ * is finished and checked first (see commit_wait()), so with FLASH_OVERLAP
+ * the flash engine writes a page while the next one is being received. Once
+ * checked, the page is recorded in the progress journal as page journal_page,
+ * unless that is -1.
+ * Returns 0 on success and -1 if the previous page failed.
+ */
+int commit_page(uint32_t page_addr, unsigned char *page, uint32_t len, int32_t journal_page){
+    if (commit_wait()){
+        return -1;
+    }
+
+    uint64_t start = profile_cycles();
+    uint8_t phase = profile_enter(PROFILE_COMPARE);
+    uint32_t erased = flash_stats.erased;
+    submit_page(page_addr, page, len);
+    profile_enter(phase);
+
+    pending_page.addr = page_addr;
+    pending_page.len = len;
+    pending_page.target = flash_target[flash_target_cur];
+    pending_page.journal = journal_page;
+    pending_page.erase = (flash_stats.erased != erased);
+    pending_page.cycles = (uint32_t)(profile_cycles() - start);
+
+#if FLASH_OVERLAP
+    return 0;
+#else
+    return commit_wait();
+#endif
+}
+
+/*
+ * Wait for the flash jobs of the last committed page and read it back. With
+ * an image digest the page as read back is folded into it, to be checked once
+ * the image is complete; otherwise it is compared with what was programmed.
+ * Returns 0 on success (or with no page pending) and -1 if programming or
+ * verification failed.
+ */
+int commit_wait(void){
+    uint32_t page_addr = pending_page.addr;
+    uint32_t len = pending_page.len;
+    if (page_addr == 0){
+        return 0;
+    }
+    pending_page.addr = 0;
+
+    uint64_t start = profile_cycles();
+    uint8_t phase = profile_enter(pending_page.erase ? PROFILE_ERASE : PROFILE_PROGRAM);
+    if (flash_wait()){
+        LOG(LOG_LEVEL_ERROR, "Flash program failed.\n");
+        return -1;
+    }
+
+    // Verify flash program
+    profile_enter(PROFILE_VERIFY);
+    if (image_digest.type != 0){
+        digest_update(&image_digest, (void *)page_addr, len);
+    }else if (memcmp(pending_page.target, (void *)page_addr, len) != 0){
+        LOG(LOG_LEVEL_ERROR, "Flash check failed.\n");
+        return -1;
+    }
+
+    if (pending_page.journal >= 0){
+        profile_enter(PROFILE_OTHER);
+        if (journal_append(pending_page.journal)){
+            return -1;
+        }
+    }
+
+    profile_enter(phase);
+    profile_page(page_addr, pending_page.cycles + (uint32_t)(profile_cycles() - start));
+
+    // Write debugging messages to UART2.
+    LOG(LOG_LEVEL_DEBUG, "Page successfully programmed\n");
+    LOG_VALUE(LOG_LEVEL_DEBUG, "Address: ", page_addr);
+    LOG_VALUE(LOG_LEVEL_DEBUG, "Bytes: ", len);
+
+    return 0;
+}
+
+/*
+ * Start an image digest of the kind selected by the image flags, if any.
+ */
+void digest_init(image_digest_t *d, uint8_t flags){
+    if (flags & IMAGE_FLAG_SHA256){
+        d->type = IMAGE_FLAG_SHA256;
+        br_sha256_init(&d->sha);
+    }else if (flags & IMAGE_FLAG_CRC32){
+        d->type = IMAGE_FLAG_CRC32;
+        d->crc = 0;
+    }else{
+        d->type = 0;
+    }
+}
+
+/*
+ * Number of bytes in the expected digest.
+ */
+uint32_t digest_size(const image_digest_t *d){
+    if (d->type == IMAGE_FLAG_SHA256){
+        return br_sha256_SIZE;
+    }
+    return (d->type == IMAGE_FLAG_CRC32) ? CRC32_SIZE : 0;
+}
+
+void digest_update(image_digest_t *d, const void *data, uint32_t len){
+    if (d->type == IMAGE_FLAG_SHA256){
+        br_sha256_update(&d->sha, data, len);
+    }else if (d->type == IMAGE_FLAG_CRC32){
+        d->crc = crc32_update(d->crc, data, len);
+    }
+}
+
+/*
+ * Compare the digest of everything committed with the expected one. The CRC
+ * is sent little endian. Returns 0 if they match and -1 if not.
+ */
+int digest_check(image_digest_t *d){
+    uint8_t out[br_sha256_SIZE];
+
+    if (d->type == IMAGE_FLAG_SHA256){
+        br_sha256_out(&d->sha, out);
+    }else{
+        for (int i = 0; i < CRC32_SIZE; i++){
+            out[i] = (d->crc >> (8 * i)) & 0xFF;
+        }
+    }
+    return (memcmp(out, d->expected, digest_size(d)) == 0) ? 0 : -1;
+}
+
+/*
+ * Switch the host connection to a faster baud rate for the next update.
+ *
+ * After the "S" handshake the host sends the rate it wants as a little
+ * endian word. The bootloader answers OK and switches, or ERROR if the UART
+ * cannot reach that rate from the current system clock. The host then
+ * switches as well and sends BAUD_CONFIRM at the new rate. If that does not
+ * arrive the bootloader falls back to UART_DEFAULT_BAUD without answering,
+ * and the host does the same when no answer comes. Otherwise the bootloader
+ * confirms with OK at the new rate, which stays in effect until the end of
+ * the next update (or a reset).
+ */
+void set_baud(void){
+    uint32_t baud = 0;
+    uint32_t matched = 0;
+    uint8_t c;
+
+    // Get the requested rate as 32 bits
+    for (int i = 0; i < 4; i++){
+        baud |= (uint32_t)uart_rx_getc() << (8 * i);
+    }
+
+    if (baud < UART_DEFAULT_BAUD || baud > SysCtlClockGet() / 16){
+        uart_write(UART1, ERROR); // Reject the rate, stay at the current one.
+        return;
+    }
+
+    uart_write(UART1, OK);
+    uart_rx_set_baud(baud);
+
+    // Wait for the confirmation, skipping anything garbled by the switch
+    for (int i = 0; matched < sizeof(BAUD_CONFIRM) - 1; i++){
+        if (i == BAUD_CONFIRM_MAX_BYTES || uart_rx_getc_timeout(&c, BAUD_CONFIRM_MS)){
+            LOG(LOG_LEVEL_WARN, "Baud rate not confirmed, falling back.\n");
+            uart_rx_set_baud(UART_DEFAULT_BAUD);
+            return;
+        }
+        if (c == BAUD_CONFIRM[matched]){
+            matched++;
+        }else{
+            matched = (c == BAUD_CONFIRM[0]) ? 1 : 0;
+        }
+    }
+
+    uart_write(UART1, OK);
+
+    LOG_VALUE(LOG_LEVEL_INFO, "Host connection at baud rate: ", baud);
+}
+
+/*
+ * Change how much is logged: after the "L" handshake the host sends the new
+ * level, from LOG_LEVEL_NONE to LOG_LEVEL_DEBUG, answered with OK. Messages
+ * compiled out with LOG_LEVEL stay out.
+ */
+void set_log_level(void){
+    uint8_t level = uart_rx_getc();
+
+    if (level > LOG_LEVEL_DEBUG){
+        uart_write(UART1, ERROR); // Reject the level.
+        return;
+    }
+    log_set_level(level);
+    uart_write(UART1, OK);
+}
+
+/*
+ * Return the host connection to the rate it has after a reset.
+ */
+void restore_baud(void){
+    if (uart_rx_baud() != UART_DEFAULT_BAUD){
+        uart_rx_set_baud(UART_DEFAULT_BAUD);
+    }
+}
+
+/*
+ * Load the firmware into flash.
+ */
+void load_firmware(void){
+    int frame_length = 0;
+    uint32_t rcv = 0;
+
+    unsigned char *data = page_buf[0];
+    uint32_t data_index = 0;
+    uint32_t page_addr = SLOT_BASE(SLOT_A);
+    uint32_t limit = 0;
+    uint32_t version = 0;
+    uint32_t size = 0;
+
+    // Legacy images are always linked for slot A, so this installs in place.
+    if (receive_metadata(SLOT_A, &version, &size)){
+        uart_write(UART1, ERROR); // Reject the metadata.
+        SysCtlReset();            // Reset device
+        return;
+    }
+
+    limit = image_limit(SLOT_A, size);
+
+    // This transfer does not keep the journal, so earlier progress is void
+    journal_close();
 
     uart_write(UART1, OK); // Acknowledge the metadata.
 
@@ -215,14 +741,22 @@ void load_firmware(void){
     while (1){
 
         // Get two bytes for the length.
-        rcv = uart_read(UART1, BLOCKING, &read);
+        rcv = uart_rx_getc();
         frame_length = (int)rcv << 8;
-        rcv = uart_read(UART1, BLOCKING, &read);
+        rcv = uart_rx_getc();
         frame_length += (int)rcv;
 
+        // The frame must fit in the page buffer and in the image
+        if ((uint32_t)frame_length > FLASH_PAGESIZE - data_index || page_addr + data_index + frame_length > limit){
+            LOG(LOG_LEVEL_ERROR, "Frame runs past the page or image.\n");
+            uart_write(UART1, ERROR); // Reject the firmware
+            SysCtlReset();            // Reset device
+            return;
+        }
+
         // Get the number of bytes specified
         for (int i = 0; i < frame_length; ++i){
-            data[data_index] = uart_read(UART1, BLOCKING, &read);
+            data[data_index] = uart_rx_getc();
             data_index += 1;
         } // for
 
@@ -230,37 +764,31 @@ void load_firmware(void){
         if (data_index == FLASH_PAGESIZE || frame_length == 0){
 
             if(frame_length == 0){
-                uart_write_str(UART2, "Got zero length frame.\n");
+                LOG(LOG_LEVEL_DEBUG, "Got zero length frame.\n");
             }
             
-            // Try to write flash and check for error
-            if (program_flash(page_addr, data, data_index)){
+            if (commit_page(page_addr, data, data_index, -1)){
                 uart_write(UART1, ERROR); // Reject the firmware
                 SysCtlReset();            // Reset device
                 return;
             }
 
-            // Verify flash program
-            if (memcmp(data, (void *) page_addr, data_index) != 0){
-                uart_write_str(UART2, "Flash check failed.\n");
-                uart_write(UART1, ERROR); // Reject the firmware
-                SysCtlReset();            // Reset device
-                return;
-            }
-
-            // Write debugging messages to UART2.
-            uart_write_str(UART2, "Page successfully programmed\nAddress: ");
-            uart_write_hex(UART2, page_addr);
-            uart_write_str(UART2, "\nBytes: ");
-            uart_write_hex(UART2, data_index);
-            nl(UART2);
-
             // Update to next page
             page_addr += FLASH_PAGESIZE;
             data_index = 0;
 
             // If at end of firmware, go to main
             if (frame_length == 0){
+                if (commit_wait()){
+                    uart_write(UART1, ERROR); // Reject the firmware
+                    SysCtlReset();            // Reset device
+                    return;
+                }
+                if (commit_metadata(SLOT_A, version, size)){
+                    uart_write(UART1, ERROR); // Reject the firmware
+                    SysCtlReset();            // Reset device
+                    return;
+                }
                 uart_write(UART1, OK);
                 break;
             }
@@ -271,84 +799,606 @@ void load_firmware(void){
 }
 
 /*
- * Program a stream of bytes to the flash.
- * This function takes the starting address of a 1KB page, a pointer to the
- * data to write, and the number of byets to write.
+ * Start assembling pages at the given offset into an image. With journal set,
+ * each full page is recorded in the progress journal once it is committed.
+ */
+void writer_init(page_writer_t *w, uint32_t base, uint32_t offset, uint32_t limit, int journal){
+    w->image_base = base;
+    w->page_addr = base + offset;
+    w->index = 0;
+    w->cur = 0;
+    w->ready = NULL;
+    w->ready_addr = 0;
+    w->limit = limit;
+    w->journal = journal;
+}
+
+/*
+ * Append one image byte. When this completes a page it becomes the ready
+ * page; a page that is still waiting from before is committed first.
+ * Returns 0 on success and -1 if a commit failed.
+ */
+int writer_put(page_writer_t *w, unsigned char c){
+    if (w->page_addr + w->index >= w->limit){
+        LOG(LOG_LEVEL_ERROR, "Image runs past its declared size.\n");
+        return -1;
+    }
+    page_buf[w->cur][w->index++] = c;
+
+    if (w->index == FLASH_PAGESIZE){
+        if (writer_commit_ready(w)){
+            return -1;
+        }
+        w->ready = page_buf[w->cur];
+        w->ready_addr = w->page_addr;
+        w->cur ^= 1;
+        w->page_addr += FLASH_PAGESIZE;
+        w->index = 0;
+    }
+    return 0;
+}
+
+/*
+ * Commit the ready page, if there is one.
+ */
+int writer_commit_ready(page_writer_t *w){
+    if (w->ready != NULL){
+        int32_t journal_page = w->journal ? (int32_t)((w->ready_addr - w->image_base) / FLASH_PAGESIZE) : -1;
+        if (commit_page(w->ready_addr, w->ready, FLASH_PAGESIZE, journal_page)){
+            return -1;
+        }
+        w->ready = NULL;
+    }
+    return 0;
+}
+
+/*
+ * Commit everything that is left, including a final partial page, and wait
+ * until it is all in flash.
+ */
+int writer_finish(page_writer_t *w){
+    if (writer_commit_ready(w)){
+        return -1;
+    }
+    if (w->index > 0 && commit_page(w->page_addr, page_buf[w->cur], w->index, -1)){
+        return -1;
+    }
+    w->index = 0;
+    return commit_wait();
+}
+
+/*
+ * Reject a v2 frame and reset. The host may still have a window of frames in
+ * flight, so wait for the line to go quiet first; otherwise the restarted
+ * bootloader would read their data as commands.
+ */
+void reject_frame(uint8_t seq){
+    uart_write(UART1, ERROR);
+    uart_write(UART1, seq);
+    uart_rx_drain(REJECT_IDLE_MS);
+    log_flush();
+    SysCtlReset();
+}
+
+/*
+ * Load the firmware into flash using the windowed (v2) protocol.
+ *
+ * After the "V" handshake the bootloader advertises its protocol version,
+ * the largest window and the largest frame it accepts, and the slot the
+ * image will be written to: always the one that is not running, so a failed
+ * update leaves the running image bootable. The host then sends
+ * the metadata and a byte of image flags, followed by frames of the form
+ *
+ *     [ seq (1) ] [ length (2, big endian) ] [ data (length) ]
+ *
+ * without waiting for each one to be acknowledged. Every accepted frame is
+ * answered with [ OK ] [ seq ]; an acknowledgement covers that frame and all
+ * frames before it, so the host may keep up to a window of frames in flight.
+ * Frames may span page boundaries. A zero length frame ends the transfer.
+ *
+ * A frame is acknowledged as soon as its data has been copied out of the
+ * receive ring, before any page it completed is programmed. A completed page
+ * goes to the flash engine (flash_engine.h), which erases and writes it from
+ * the flash controller interrupt while the host keeps streaming into the ring
+ * and the following bytes are assembled in the other page buffer. A
+ * programming failure is reported in place of a later acknowledgement.
+ *
+ * With IMAGE_FLAG_LZ the frame data is a compressed stream. It is decoded a
+ * byte at a time straight into the page buffers, so only the decoder's
+ * history window is held in RAM rather than the whole image.
+ *
+ * The flags are followed by a 32-bit image identity chosen by the host. Every
+ * committed page of an uncompressed image is recorded in the progress
+ * journal, and the metadata is acknowledged with OK and a 32-bit resume
+ * offset: the number of image bytes already committed for this identity by an
+ * earlier, interrupted session. Frames then start at that offset, with the
+ * sequence number starting again from zero. Compressed images always start
+ * from zero since the decoder state cannot be recovered.
+ *
+ * With IMAGE_FLAG_CRC32 or IMAGE_FLAG_SHA256 the identity is followed by a
+ * digest of the whole (decoded) image. Each page is folded into it as read
+ * back from flash once programmed, instead of being compared with its
+ * buffer, and the image is only made bootable if the digests match.
+ *
+ * IMAGE_FLAG_SLOT_B must match the advertised slot, since images are linked
+ * for the address they run from. The slot is made the one to boot only after
+ * its last page has been written.
+ */
+void load_firmware_v2(void){
+    int frame_length = 0;
+    uint32_t rcv = 0;
+
+    uint8_t seq = 0;
+    uint8_t expected_seq = 0;
+    uint8_t flags = 0;
+    int decoded_len = 0;
+    uint32_t version = 0;
+    uint32_t size = 0;
+    uint32_t image_id = 0;
+    uint32_t resume = 0;
+    uint32_t slot = update_slot();
+    page_writer_t writer;
+
+    // Advertise protocol version, window, frame size (little endian) and the
+    // slot the image will be written to.
+    uart_write(UART1, PROTOCOL_VERSION);
+    uart_write(UART1, MAX_WINDOW);
+    uart_write(UART1, MAX_FRAME_SIZE & 0xFF);
+    uart_write(UART1, (MAX_FRAME_SIZE >> 8) & 0xFF);
+    uart_write(UART1, slot);
+
+    if (receive_metadata(slot, &version, &size)){
+        uart_write(UART1, ERROR); // Reject the metadata.
+        SysCtlReset();            // Reset device
+        return;
+    }
+
+    flags = uart_rx_getc();
+    if ((flags & ~IMAGE_FLAGS) || (flags & IMAGE_FLAG_CRC32 && flags & IMAGE_FLAG_SHA256)){
+        uart_write(UART1, ERROR); // Reject unknown image formats.
+        SysCtlReset();            // Reset device
+        return;
+    }
+    if (((flags & IMAGE_FLAG_SLOT_B) ? SLOT_B : SLOT_A) != slot){
+        LOG(LOG_LEVEL_ERROR, "Image is linked for the other slot.\n");
+        uart_write(UART1, ERROR); // Reject the image.
+        SysCtlReset();            // Reset device
+        return;
+    }
+
+    // Get the image identity as 32 bits
+    for (int i = 0; i < 4; i++){
+        image_id |= (uint32_t)uart_rx_getc() << (8 * i);
+    }
+
+    // Get the digest of the whole image, if there is one
+    digest_init(&image_digest, flags);
+    for (uint32_t i = 0; i < digest_size(&image_digest); i++){
+        image_digest.expected[i] = uart_rx_getc();
+    }
+
+    if (flags & IMAGE_FLAG_LZ){
+        journal_close();
+    }else{
+        resume = journal_resume(image_id, ((size & 0xFFFF) << 16) | (version & 0xFFFF)) * FLASH_PAGESIZE;
+    }
+
+    if (resume != 0){
+        LOG_VALUE(LOG_LEVEL_INFO, "Resuming update at offset: ", resume);
+
+        // Pages committed by the earlier session count towards the digest
+        profile_enter(PROFILE_VERIFY);
+        digest_update(&image_digest, (void *)SLOT_BASE(slot), resume);
+        profile_enter(PROFILE_RECEIVE);
+    }
+
+    uart_write(UART1, OK); // Acknowledge the metadata with the resume offset.
+    for (int i = 0; i < 4; i++){
+        uart_write(UART1, (resume >> (8 * i)) & 0xFF);
+    }
+
+    writer_init(&writer, SLOT_BASE(slot), resume, image_limit(slot, size), !(flags & IMAGE_FLAG_LZ));
+    lz_init(&lz);
+
+    while (1){
+
+        // Get the sequence number and two bytes for the length.
+        seq = uart_rx_getc();
+        rcv = uart_rx_getc();
+        frame_length = (int)rcv << 8;
+        rcv = uart_rx_getc();
+        frame_length += (int)rcv;
+
+        if (seq != expected_seq || frame_length > MAX_FRAME_SIZE){
+            LOG(LOG_LEVEL_ERROR, "Bad frame header.\n");
+            reject_frame(expected_seq);
+            return;
+        }
+
+        // Get the number of bytes specified, decoding them if compressed
+        for (int i = 0; i < frame_length; ++i){
+            unsigned char c = uart_rx_getc();
+
+            if (flags & IMAGE_FLAG_LZ){
+                decoded_len = lz_decode_byte(&lz, c, lz_out);
+            }else{
+                lz_out[0] = c;
+                decoded_len = 1;
+            }
+
+            if (decoded_len < 0){
+                LOG(LOG_LEVEL_ERROR, "Bad compressed data.\n");
+                reject_frame(seq);
+                return;
+            }
+
+            for (int j = 0; j < decoded_len; ++j){
+                if (writer_put(&writer, lz_out[j])){
+                    reject_frame(seq);
+                    return;
+                }
+            }
+        } // for
+
+        if (frame_length == 0){
+            LOG(LOG_LEVEL_DEBUG, "Got zero length frame.\n");
+
+            // Program the last pages, including a final partial page
+            if (writer_finish(&writer)){
+                reject_frame(seq);
+                return;
+            }
+
+            // The image is complete; nothing is left to resume
+            journal_close();
+
+            if (digest_check(&image_digest)){
+                LOG(LOG_LEVEL_ERROR, "Image digest mismatch.\n");
+                reject_frame(seq);
+                return;
+            }
+
+            if (commit_metadata(slot, version, size)){
+                reject_frame(seq);
+                return;
+            }
+
+            uart_write(UART1, OK);
+            uart_write(UART1, seq);
+            break;
+        }
+
+        uart_write(UART1, OK); // Acknowledge this frame and all before it.
+        uart_write(UART1, seq);
+        expected_seq++;
+
+        // Program the completed page while the host keeps sending.
+        if (writer_commit_ready(&writer)){
+            reject_frame(seq);
+            return;
+        }
+    } // while(1)
+
+    if (uart_rx_overruns() != 0){
+        LOG_VALUE(LOG_LEVEL_WARN, "Receive overruns: ", uart_rx_overruns());
+    }
+}
+
+/*
+ * Load only the pages of a new image that differ from the installed one.
+ *
+ * After the "D" handshake the bootloader sends the slot the image will be
+ * written to, as for the v2 protocol, and the pages are compared against
+ * that slot. The host then sends the metadata, the image flags (only
+ * IMAGE_FLAG_SLOT_B, which must match the slot as for the v2 protocol) and
+ * the number of pages the new image (firmware and release message) occupies,
+ * as a little endian short. The bootloader answers OK and the SHA-256 digest of
+ * each of those pages as currently installed, read over the full page so the
+ * erased tail of the last page is included. The host then sends only the
+ * pages whose digest differs:
  *
- * This functions performs an erase of the specified flash page before writing
- * the data.
+ *     [ page index (2, big endian) ] [ length (2, big endian) ] [ data ]
+ *
+ * Each page is acknowledged with OK once its programming has started, and the
+ * host waits for that before sending the next. A programming failure is
+ * reported in place of a later acknowledgement. A page index of END_OF_PAGES
+ * ends the transfer, and is acknowledged once every page is in flash.
  */
-long program_flash(uint32_t page_addr, unsigned char *data, unsigned int data_len){
-    uint32_t word = 0;
-    int ret;
+void load_firmware_delta(void){
+    uint32_t rcv = 0;
+    uint32_t version = 0;
+    uint32_t size = 0;
+    uint32_t page_count = 0;
+    uint32_t page_index = 0;
+    uint32_t frame_length = 0;
+    uint32_t changed = 0;
+    uint32_t flags = 0;
+    uint32_t slot = update_slot();
+
+    // Tell the host which slot the pages are for, so it can pick the image
+    // linked for it.
+    uart_write(UART1, slot);
+
+    if (receive_metadata(slot, &version, &size)){
+        uart_write(UART1, ERROR); // Reject the metadata.
+        SysCtlReset();            // Reset device
+        return;
+    }
+
+    flags = uart_rx_getc();
+    if (flags & ~IMAGE_FLAG_SLOT_B){
+        uart_write(UART1, ERROR); // Reject unknown image formats.
+        SysCtlReset();            // Reset device
+        return;
+    }
+    if (((flags & IMAGE_FLAG_SLOT_B) ? SLOT_B : SLOT_A) != slot){
+        LOG(LOG_LEVEL_ERROR, "Image is linked for the other slot.\n");
+        uart_write(UART1, ERROR); // Reject the image.
+        SysCtlReset();            // Reset device
+        return;
+    }
+
+    rcv = uart_rx_getc();
+    page_count = rcv;
+    rcv = uart_rx_getc();
+    page_count |= rcv << 8;
+
+    // The pages may hold no more than the image and its release message
+    if (page_count > (image_limit(slot, size) - SLOT_BASE(slot) + FLASH_PAGESIZE - 1) / FLASH_PAGESIZE){
+        LOG(LOG_LEVEL_ERROR, "Image runs past its declared size.\n");
+        uart_write(UART1, ERROR); // Reject the metadata.
+        SysCtlReset();            // Reset device
+        return;
+    }
+
+    // This transfer does not keep the journal, so earlier progress is void
+    journal_close();
+
+    uart_write(UART1, OK); // Acknowledge the metadata.
+
+    // Report the digest of every page the new image will occupy.
+    profile_enter(PROFILE_OTHER);
+    for (uint32_t i = 0; i < page_count; i++){
+        br_sha256_init(&page_sha);
+        br_sha256_update(&page_sha, (void *)(SLOT_BASE(slot) + i * FLASH_PAGESIZE), FLASH_PAGESIZE);
+        br_sha256_out(&page_sha, page_digest);
+        for (int j = 0; j < PAGE_DIGEST_SIZE; j++){
+            uart_write(UART1, page_digest[j]);
+        }
+    }
+    profile_enter(PROFILE_RECEIVE);
+
+    while (1){
+        rcv = uart_rx_getc();
+        page_index = rcv << 8;
+        rcv = uart_rx_getc();
+        page_index |= rcv;
+        rcv = uart_rx_getc();
+        frame_length = rcv << 8;
+        rcv = uart_rx_getc();
+        frame_length |= rcv;
+
+        if (page_index == END_OF_PAGES){
+            break;
+        }
+
+        if (page_index >= page_count || frame_length > FLASH_PAGESIZE){
+            LOG(LOG_LEVEL_ERROR, "Bad page header.\n");
+            uart_write(UART1, ERROR); // Reject the page
+            SysCtlReset();            // Reset device
+            return;
+        }
+
+        for (uint32_t i = 0; i < frame_length; ++i){
+            page_buf[0][i] = uart_rx_getc();
+        }
+
+        if (commit_page(SLOT_BASE(slot) + page_index * FLASH_PAGESIZE, page_buf[0], frame_length, -1)){
+            uart_write(UART1, ERROR); // Reject the firmware
+            SysCtlReset();            // Reset device
+            return;
+        }
+        changed++;
+
+        uart_write(UART1, OK); // Acknowledge the page.
+    }
+
+    if (commit_wait()){
+        uart_write(UART1, ERROR); // Reject the firmware
+        SysCtlReset();            // Reset device
+        return;
+    }
+
+    LOG_VALUE(LOG_LEVEL_INFO, "Delta update changed pages: ", changed);
+    LOG_VALUE(LOG_LEVEL_INFO, "Delta update total pages: ", page_count);
+
+    if (commit_metadata(slot, version, size)){
+        uart_write(UART1, ERROR); // Reject the firmware
+        SysCtlReset();            // Reset device
+        return;
+    }
+    uart_write(UART1, OK); // Acknowledge the end of the transfer.
+}
+
+/*
+ * Queue the flash jobs that write a page, without waiting for them.
+ *
+ * The page ends up holding the data followed by erased (0xFF) bytes, exactly
+ * as if it had been erased and written. The current contents are checked
+ * first: a page that already matches is left alone, and the erase is skipped
+ * when every word only needs bits cleared. Only words that differ are
+ * programmed. The jobs program from a copy of the data, so the caller may
+ * reuse its buffer straight away.
+ */
+void submit_page(uint32_t page_addr, unsigned char *data, unsigned int data_len){
+    uint32_t *flash = (uint32_t *)page_addr;
+    uint32_t *target;
+    int need_erase = 0;
+    int dirty = 0;
     int i;
 
-    // Erase next FLASH page
-    FlashErase(page_addr);
-
-    // Clear potentially unused bytes in last word
-    // If data not a multiple of 4 (word size), program up to the last word
-    // Then create temporary variable to create a full last word
-    if (data_len % FLASH_WRITESIZE){
-        // Get number of unused bytes
-        int rem = data_len % FLASH_WRITESIZE;
-        int num_full_bytes = data_len - rem;
-
-        // Program up to the last word
-        ret = FlashProgram((unsigned long *)data, page_addr, num_full_bytes);
-        if (ret != 0){
-            return ret;
+    // Take the copy the page before last was programmed from, once its jobs
+    // have finished
+    flash_target_cur ^= 1;
+    target = flash_target[flash_target_cur];
+    while ((int32_t)(flash_jobs_done() - flash_target_jobs[flash_target_cur]) < 0){
+    }
+
+    // Build the desired page contents, padding unused bytes with 0xFF
+    memset(target, 0xFF, FLASH_PAGESIZE);
+    memcpy(target, data, data_len);
+
+    for (i = 0; i < FLASH_PAGESIZE / FLASH_WRITESIZE; i++){
+        if (flash[i] != target[i]){
+            dirty = 1;
+            if ((flash[i] & target[i]) != target[i]){
+                // A bit has to go from 0 back to 1
+                need_erase = 1;
+                break;
+            }
         }
+    }
 
-        // Create last word variable -- fill unused with 0xFF
-        for (i = 0; i < rem; i++){
-            word = (word >> 8) | (data[num_full_bytes + i] << 24); // Essentially a shift register from MSB->LSB
+    if (!dirty){
+        flash_stats.skipped++;
+        return;
+    }
+
+    if (need_erase){
+        while (flash_submit_erase(page_addr)){
         }
-        for (i = i; i < 4; i++){
-            word = (word >> 8) | 0xFF000000;
+        flash_stats.erased++;
+    }
+
+    // Program each run of words that differ from what is in flash, which
+    // reads as erased once the queued erase has run
+    i = 0;
+    while (i < FLASH_PAGESIZE / FLASH_WRITESIZE){
+        uint32_t current = need_erase ? 0xFFFFFFFF : flash[i];
+        if (current == target[i]){
+            i++;
+            continue;
         }
 
-        // Program word
-        return FlashProgram(&word, page_addr + num_full_bytes, 4);
-    }else{
-        // Write full buffer of 4-byte words
-        return FlashProgram((unsigned long *)data, page_addr, data_len);
+        int start = i;
+        while (i < FLASH_PAGESIZE / FLASH_WRITESIZE && (need_erase ? 0xFFFFFFFF : flash[i]) != target[i]){
+            i++;
+        }
+
+        while (flash_submit_program(page_addr + start * FLASH_WRITESIZE, &target[start], i - start)){
+        }
+    }
+
+    flash_target_jobs[flash_target_cur] = flash_jobs_submitted();
+    flash_stats.programmed++;
+}
+
+/*
+ * Log the flash statistics of the last update.
+ */
+void report_flash_stats(void){
+    LOG_VALUE(LOG_LEVEL_INFO, "Pages erased: ", flash_stats.erased);
+    LOG_VALUE(LOG_LEVEL_INFO, "Pages programmed: ", flash_stats.programmed);
+    LOG_VALUE(LOG_LEVEL_INFO, "Pages unchanged: ", flash_stats.skipped);
+    if (log_dropped() != 0){
+        LOG_VALUE(LOG_LEVEL_WARN, "Log messages dropped: ", log_dropped());
+    }
+}
+
+/*
+ * Send the cycle profile of the last update to the host:
+ *
+ *     [ clock (4) ] [ phase count (1) ] [ cycles (8) per phase ]
+ *     [ page count (2) ] [ cycles (4) per page ]
+ *
+ * all little endian. Phases are numbered as in profile.h; pages count from
+ * the start of the slot that was written and are 0 if they were not.
+ */
+void send_profile(void){
+    uint32_t clock = SysCtlClockGet();
+    uint32_t pages = profile_pages();
+
+    for (int i = 0; i < 4; i++){
+        uart_write(UART1, (clock >> (8 * i)) & 0xFF);
+    }
+
+    uart_write(UART1, PROFILE_PHASES);
+    for (uint8_t phase = 0; phase < PROFILE_PHASES; phase++){
+        uint64_t cycles = profile_phase_cycles(phase);
+        for (int i = 0; i < 8; i++){
+            uart_write(UART1, (cycles >> (8 * i)) & 0xFF);
+        }
+    }
+
+    uart_write(UART1, pages & 0xFF);
+    uart_write(UART1, (pages >> 8) & 0xFF);
+    for (uint32_t page = 0; page < pages; page++){
+        uint32_t cycles = profile_page_cycles(page);
+        for (int i = 0; i < 4; i++){
+            uart_write(UART1, (cycles >> (8 * i)) & 0xFF);
+        }
     }
 }
 
 void boot_firmware(void){
+    uint64_t boot_start = profile_cycles();
+    int slot = boot_slot();
+
+    if (slot < 0){
+        LOG(LOG_LEVEL_ERROR, "No firmware to boot.\n");
+        return;
+    }
+
+    memory_report();
+
+    // The firmware writes to UART2 directly; finish what is queued first
+    log_disable();
+
     // compute the release message address, and then print it
-    uint16_t fw_size = *fw_size_address;
-    fw_release_message_address = (uint8_t *)(FW_BASE + fw_size);
+    uint16_t fw_size = metadata->slot[slot] >> 16;
+    fw_release_message_address = (uint8_t *)(SLOT_BASE(slot) + fw_size);
     uart_write_str(UART2, (char *)fw_release_message_address);
 
-    // Boot the firmware
+    // The firmware does not expect the host connection to interrupt it, and
+    // talks to the host at the default rate
+    uart_rx_disable();
+    restore_baud();
+
+    // Nothing is left queued for the flash controller, and the firmware does
+    // not expect its interrupt
+    flash_engine_disable();
+
+    // Tell the firmware how long booting took so far, from reset (saturated)
+    // and from the boot command, in cycles of the clock it runs at. Read
+    // while the wrap interrupt still counts.
+    uint64_t now = profile_cycles();
+    uint64_t boot_cycles = now - boot_start;
+    uint32_t hz = SysCtlClockGet();
+
+    // The firmware runs SysTick itself, without the interrupt
+    profile_disable();
+
+    // The firmware expects the reset clock, and UARTs set up for it
+    clock_restore();
+    uart_init(UART0);
+    uart_init(UART1);
+    uart_init(UART2);
+
+    now = profile_scale(now, hz, clock_reset_hz());
+    boot_cycles = profile_scale(boot_cycles, hz, clock_reset_hz());
+    uint32_t since_reset = (now > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)now;
+    uint32_t since_boot = (uint32_t)boot_cycles;
+
+    // Hand off through the firmware's vector table: the first word is its
+    // stack pointer and the second its entry point, which takes the timings
+    // as arguments. Interrupts stay masked until the firmware has set up RAM.
+    const uint32_t *vectors = (const uint32_t *)SLOT_BASE(slot);
+    IntMasterDisable();
+    HWREG(NVIC_VTABLE) = SLOT_BASE(slot);
     __asm(
-        "LDR R0,=0x10001\n\t"
-        "BX R0\n\t");
+        "MSR MSP, %0\n\t"
+        "MOV R0, %2\n\t"
+        "MOV R1, %3\n\t"
+        "BX %1\n\t"
+        : : "r"(vectors[0]), "r"(vectors[1]), "r"(since_reset), "r"(since_boot) : "r0", "r1");
 }
-
-void uart_write_hex_bytes(uint8_t uart, uint8_t * start, uint32_t len) {
-    for (uint8_t * cursor = start; cursor < (start + len); cursor += 1) {
-        uint8_t data = *((uint8_t *)cursor);
-        uint8_t right_nibble = data & 0xF;
-        uint8_t left_nibble = (data >> 4) & 0xF;
-        char byte_str[3];
-        if (right_nibble > 9) {
-            right_nibble += 0x37;
-        } else {
-            right_nibble += 0x30;
-        }
-        byte_str[1] = right_nibble;
-        if (left_nibble > 9) {
-            left_nibble += 0x37;
-        } else {
-            left_nibble += 0x30;
-        }
-        byte_str[0] = left_nibble;
-        byte_str[2] = '\0';
-        
-        uart_write_str(uart, byte_str);
-        uart_write_str(uart, " ");
-    }
-}
\ No newline at end of file
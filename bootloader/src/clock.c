@@ -0,0 +1,61 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+// Hardware Imports
+#include "inc/hw_memmap.h" // Peripheral Base Addresses
+#include "inc/hw_sysctl.h" // System control registers
+#include "inc/hw_types.h"  // Boolean type
+
+// Driver API Imports
+#include "driverlib/flash.h"  // FLASH API
+#include "driverlib/sysctl.h" // System control API (clock/reset)
+#include "driverlib/uart.h"   // UART API
+
+// Application Imports
+#include "clock.h"
+
+static uint32_t reset_rcc;
+static uint32_t reset_hz;
+
+/*
+ * Flash erase and program timing is counted in system clocks, so it has to
+ * follow every clock change.
+ */
+static void clock_changed(void){
+    FlashUsecSet(SysCtlClockGet() / 1000000);
+}
+
+/*
+ * Remember the reset clock and switch to the PLL. Call before anything
+ * derives a rate from the clock (UART divisors, delays, SysTick timings).
+ */
+void clock_init(void){
+    reset_rcc = HWREG(SYSCTL_RCC);
+    reset_hz = SysCtlClockGet();
+
+#if CLOCK_PLL
+    SysCtlClockSet(SYSCTL_SYSDIV_4 | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN | SYSCTL_XTAL_8MHZ);
+#endif
+    clock_changed();
+}
+
+/*
+ * Go back to the clock the part was reset with, e.g. before handing off to
+ * firmware that expects it. Anything still being transmitted is sent at the
+ * old rate first; UART divisors have to be set again afterwards.
+ */
+void clock_restore(void){
+    while (UARTBusy(UART0_BASE) || UARTBusy(UART1_BASE) || UARTBusy(UART2_BASE)){
+    }
+
+    // SysCtlClockSet() takes its configuration in the layout of RCC
+    SysCtlClockSet(reset_rcc);
+    clock_changed();
+}
+
+/*
+ * Frequency of the clock the part was reset with.
+ */
+uint32_t clock_reset_hz(void){
+    return reset_hz;
+}
@@ -0,0 +1,198 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+// Hardware Imports
+#include "inc/hw_flash.h" // Flash controller registers
+#include "inc/hw_types.h" // Boolean type
+#include "inc/hw_ints.h"  // Interrupt numbers
+
+// Driver API Imports
+#include "driverlib/flash.h"     // FLASH API
+#include "driverlib/interrupt.h" // Interrupt API
+
+// Library Imports
+#include <stddef.h>
+
+// Application Imports
+#include "flash_engine.h"
+#include "flash_layout.h"
+
+// One page erase, or a run of words to program one at a time
+typedef struct {
+    uint32_t addr;        // page to erase, or the next word to program
+    const uint32_t *data; // the next word's data; NULL for an erase
+    uint32_t words;       // words left to program
+} flash_job_t;
+
+static flash_job_t queue[FLASH_QUEUE_SIZE];
+static volatile uint32_t submitted = 0; // only written by the main loop
+static volatile uint32_t done = 0;      // only written by the interrupt
+static volatile uint32_t failed = 0;
+
+/*
+ * Hand the next operation of a job to the flash controller. It raises the
+ * programming interrupt once the erase or word write has finished.
+ */
+static void flash_start(const flash_job_t *job){
+    HWREG(FLASH_FMA) = job->addr;
+    if (job->data == NULL){
+        HWREG(FLASH_FMC) = FLASH_FMC_WRKEY | FLASH_FMC_ERASE;
+    }else{
+        HWREG(FLASH_FMD) = *job->data;
+        HWREG(FLASH_FMC) = FLASH_FMC_WRKEY | FLASH_FMC_WRITE;
+    }
+}
+
+/*
+ * Advance the running job when the controller finishes an operation, and
+ * start the next job when it is complete. An access error (e.g. a protected
+ * page) ends the job and is reported by the next flash_wait().
+ */
+void FLASH_IRQHandler(void){
+    uint32_t status = FlashIntGetStatus(true);
+    FlashIntClear(status);
+
+    if (status == 0 || done == submitted){
+        return;
+    }
+
+    flash_job_t *job = &queue[done & (FLASH_QUEUE_SIZE - 1)];
+    if (status & FLASH_INT_ACCESS){
+        failed = 1;
+    }else if (job->data != NULL && --job->words != 0){
+        job->addr += FLASH_WRITESIZE;
+        job->data++;
+        flash_start(job);
+        return;
+    }
+
+    done++;
+    if (done != submitted){
+        flash_start(&queue[done & (FLASH_QUEUE_SIZE - 1)]);
+    }
+}
+
+/*
+ * Queue a job, starting it straight away if the controller is idle.
+ * Returns 0, or -1 if the queue is full.
+ */
+static int flash_submit(uint32_t addr, const uint32_t *data, uint32_t words){
+    if (submitted - done == FLASH_QUEUE_SIZE){
+        return -1;
+    }
+
+    flash_job_t *job = &queue[submitted & (FLASH_QUEUE_SIZE - 1)];
+    job->addr = addr;
+    job->data = data;
+    job->words = words;
+
+    // The interrupt must not finish the last job between the two steps
+    IntDisable(INT_FLASH);
+    int idle = (submitted == done);
+    submitted++;
+    if (idle){
+        flash_start(job);
+    }
+    IntEnable(INT_FLASH);
+    return 0;
+}
+
+/*
+ * Take completion interrupts from the flash controller. From here on every
+ * erase and program must go through the engine: the interrupt clears the
+ * status that driverlib's FlashErase() and FlashProgram() check for errors.
+ */
+void flash_engine_init(void){
+    FlashIntClear(FLASH_INT_PROGRAM | FLASH_INT_ACCESS);
+    FlashIntEnable(FLASH_INT_PROGRAM | FLASH_INT_ACCESS);
+    IntEnable(INT_FLASH);
+}
+
+/*
+ * Finish what is queued and stop taking interrupts, e.g. before handing off
+ * to firmware.
+ */
+void flash_engine_disable(void){
+    flash_wait();
+    IntDisable(INT_FLASH);
+    FlashIntDisable(FLASH_INT_PROGRAM | FLASH_INT_ACCESS);
+}
+
+/*
+ * Queue an erase of the page at page_addr.
+ * Returns 0, or -1 if the queue is full; poll and try again.
+ */
+int flash_submit_erase(uint32_t page_addr){
+    return flash_submit(page_addr, NULL, 0);
+}
+
+/*
+ * Queue programming words words from data to addr. The data must stay as it
+ * is until the job has finished (see flash_jobs_done()).
+ * Returns 0, or -1 if the queue is full; poll and try again.
+ */
+int flash_submit_program(uint32_t addr, const uint32_t *data, uint32_t words){
+    if (words == 0){
+        return 0;
+    }
+    return flash_submit(addr, data, words);
+}
+
+/*
+ * Erase the page at page_addr and wait for it, and for anything queued
+ * before it, e.g. for journal and metadata writes that must be in flash
+ * before going on.
+ * Returns 0, or -1 if the erase or an earlier job failed.
+ */
+int flash_erase_sync(uint32_t page_addr){
+    while (flash_submit_erase(page_addr)){
+    }
+    return flash_wait();
+}
+
+/*
+ * Program words words from data to addr and wait for it, like
+ * flash_erase_sync().
+ * Returns 0, or -1 if programming or an earlier job failed.
+ */
+int flash_program_sync(uint32_t addr, const uint32_t *data, uint32_t words){
+    while (flash_submit_program(addr, data, words)){
+    }
+    return flash_wait();
+}
+
+/*
+ * Number of jobs submitted that have not finished yet.
+ */
+uint32_t flash_poll(void){
+    return submitted - done;
+}
+
+/*
+ * Running count of jobs submitted. Only the main loop changes it, so unlike
+ * flash_jobs_done() + flash_poll() it cannot be torn by a job finishing.
+ */
+uint32_t flash_jobs_submitted(void){
+    return submitted;
+}
+
+/*
+ * Running count of finished jobs. A job is finished once this has reached
+ * flash_jobs_submitted() as read just after submitting it.
+ */
+uint32_t flash_jobs_done(void){
+    return done;
+}
+
+/*
+ * Wait until every queued job has finished.
+ * Returns 0, or -1 if any job failed since the last wait.
+ */
+int flash_wait(void){
+    while (submitted != done){
+    }
+
+    int ret = failed ? -1 : 0;
+    failed = 0;
+    return ret;
+}
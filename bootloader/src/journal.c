@@ -0,0 +1,80 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+// Application Imports
+#include "flash_engine.h"
+#include "flash_layout.h"
+#include "journal.h"
+
+/*
+ * The journal occupies the page at JOURNAL_BASE:
+ *
+ *     [ magic ] [ image id ] [ metadata ] [ page 0 ] [ page 1 ] ...
+ *
+ * Each committed page appends its index as one word, so progress is
+ * recorded without erasing anything. Pages are committed in order, so the
+ * number of records is the number of pages that may be skipped on resume.
+ */
+#define JOURNAL_MAGIC 0x4C4E524A // "JRNL"
+#define JOURNAL_HEADER_WORDS 3
+#define JOURNAL_SLOTS (FLASH_PAGESIZE / FLASH_WRITESIZE - JOURNAL_HEADER_WORDS)
+#define ERASED_WORD 0xFFFFFFFF
+
+static uint32_t * const journal = (uint32_t *)JOURNAL_BASE;
+
+/*
+ * Count the consecutive page records in the journal.
+ */
+static uint32_t journal_count(void){
+    uint32_t n = 0;
+    while (n < JOURNAL_SLOTS && journal[JOURNAL_HEADER_WORDS + n] == n){
+        n++;
+    }
+    return n;
+}
+
+/*
+ * Look for progress on the given image. If the journal belongs to it,
+ * return how many pages were already committed. Otherwise start a new
+ * journal for it and return 0.
+ */
+uint32_t journal_resume(uint32_t image_id, uint32_t metadata){
+    uint32_t header[JOURNAL_HEADER_WORDS];
+
+    if (journal[0] == JOURNAL_MAGIC && journal[1] == image_id && journal[2] == metadata){
+        return journal_count();
+    }
+
+    header[0] = JOURNAL_MAGIC;
+    header[1] = image_id;
+    header[2] = metadata;
+    flash_erase_sync(JOURNAL_BASE);
+    flash_program_sync(JOURNAL_BASE, header, JOURNAL_HEADER_WORDS);
+    return 0;
+}
+
+/*
+ * Record that a page has been programmed and verified.
+ * Returns 0 on success and -1 if the record could not be written.
+ */
+int journal_append(uint32_t page_index){
+    uint32_t record = page_index;
+
+    if (page_index >= JOURNAL_SLOTS){
+        return -1;
+    }
+    if (flash_program_sync(JOURNAL_BASE + (JOURNAL_HEADER_WORDS + page_index) * FLASH_WRITESIZE, &record, 1)){
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Forget any progress, e.g. once an update completes or when flash is
+ * written by a path that does not keep the journal.
+ */
+void journal_close(void){
+    if (journal[0] != ERASED_WORD){
+        flash_erase_sync(JOURNAL_BASE);
+    }
+}
@@ -0,0 +1,171 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+// Hardware Imports
+#include "inc/hw_memmap.h" // Peripheral Base Addresses
+#include "inc/hw_types.h"  // Boolean type
+#include "inc/hw_ints.h"   // Interrupt numbers
+
+// Driver API Imports
+#include "driverlib/interrupt.h" // Interrupt API
+#include "driverlib/uart.h"      // UART API
+
+// Library Imports
+#include <string.h>
+
+// Application Imports
+#include "log.h"
+#include "memory.h"
+#include "ring_buffer.h"
+
+// Longest message log_value() builds: the string, "0x", 8 digits, newline
+#define LOG_VALUE_MAX 96
+
+static uint8_t tx_storage[LOG_TX_BUFFER_SIZE] ARENA;
+static ring_buffer_t tx_ring = RING_INIT(tx_storage);
+static uint8_t runtime_level = LOG_LEVEL;
+static uint32_t dropped = 0;
+
+static const char hex_digits[] = "0123456789ABCDEF";
+
+/*
+ * Move queued bytes into the UART2 FIFO until either runs out. Called from
+ * the transmit interrupt, and from the main loop with it masked.
+ */
+static void log_fill_fifo(void){
+    uint8_t c;
+    while (UARTSpaceAvail(UART2_BASE) && ring_get(&tx_ring, &c) == 0){
+        UARTCharPutNonBlocking(UART2_BASE, c);
+    }
+}
+
+/*
+ * Refill the FIFO each time it drains below its trigger level.
+ */
+void UART2_IRQHandler(void){
+    uint32_t status = UARTIntStatus(UART2_BASE, true);
+    UARTIntClear(UART2_BASE, status);
+
+    log_fill_fifo();
+}
+
+/*
+ * Queue a message, or drop it if it does not fit in full, then make sure
+ * the FIFO is being fed. The transmit interrupt only fires on the FIFO
+ * draining, so an idle UART has to be primed from here.
+ */
+static void log_queue(const uint8_t *msg, uint32_t len){
+    if (ring_space(&tx_ring) < len){
+        dropped++;
+        return;
+    }
+    for (uint32_t i = 0; i < len; i++){
+        ring_put(&tx_ring, msg[i]);
+    }
+
+    IntDisable(INT_UART2);
+    log_fill_fifo();
+    IntEnable(INT_UART2);
+}
+
+/*
+ * Errors go out synchronously, after anything already queued, so that they
+ * are seen even when the device resets straight afterwards.
+ */
+static void log_write(uint8_t level, const uint8_t *msg, uint32_t len){
+    if (level > runtime_level){
+        return;
+    }
+    if (level == LOG_LEVEL_ERROR){
+        log_flush();
+        for (uint32_t i = 0; i < len; i++){
+            UARTCharPut(UART2_BASE, msg[i]);
+        }
+        return;
+    }
+    log_queue(msg, len);
+}
+
+/*
+ * Start interrupt driven transmission. uart_init(UART2) must have been called.
+ */
+void log_init(void){
+    UARTFIFOLevelSet(UART2_BASE, UART_FIFO_TX4_8, UART_FIFO_RX4_8);
+    UARTIntEnable(UART2_BASE, UART_INT_TX);
+    IntEnable(INT_UART2);
+}
+
+/*
+ * Send whatever is queued and stop using the transmit interrupt, e.g. before
+ * handing off to firmware.
+ */
+void log_disable(void){
+    log_flush();
+    IntDisable(INT_UART2);
+    UARTIntDisable(UART2_BASE, UART_INT_TX);
+}
+
+void log_set_level(uint8_t level){
+    runtime_level = level;
+}
+
+uint8_t log_level(void){
+    return runtime_level;
+}
+
+void log_str(uint8_t level, const char *str){
+    log_write(level, (const uint8_t *)str, strlen(str));
+}
+
+void log_value(uint8_t level, const char *str, uint32_t value){
+    uint8_t msg[LOG_VALUE_MAX];
+    uint32_t len = strlen(str);
+
+    if (len > LOG_VALUE_MAX - 11){
+        len = LOG_VALUE_MAX - 11;
+    }
+    memcpy(msg, str, len);
+    msg[len++] = '0';
+    msg[len++] = 'x';
+    for (int shift = 28; shift >= 0; shift -= 4){
+        msg[len++] = hex_digits[(value >> shift) & 0xF];
+    }
+    msg[len++] = '\n';
+
+    log_write(level, msg, len);
+}
+
+/*
+ * Log bytes as space separated hex pairs, one line at a time.
+ */
+void log_hex_bytes(uint8_t level, const uint8_t *data, uint32_t len){
+    uint8_t line[16 * 3];
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < len; i++){
+        line[n++] = hex_digits[data[i] >> 4];
+        line[n++] = hex_digits[data[i] & 0xF];
+        line[n++] = ' ';
+        if (n == sizeof(line) || i == len - 1){
+            line[n - 1] = '\n';
+            log_write(level, line, n);
+            n = 0;
+        }
+    }
+}
+
+/*
+ * Wait until everything queued has been handed to the UART, by polling, so
+ * that this also works with interrupts masked.
+ */
+void log_flush(void){
+    IntDisable(INT_UART2);
+    while (ring_count(&tx_ring) != 0){
+        log_fill_fifo();
+    }
+    IntEnable(INT_UART2);
+}
+
+uint32_t log_dropped(void){
+    return dropped;
+}
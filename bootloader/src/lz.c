@@ -0,0 +1,70 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+#include "lz.h"
+
+// Decoder states
+#define LZ_FLAGS 0    // expecting a flag byte
+#define LZ_ITEM 1     // expecting a literal or the first byte of a match
+#define LZ_MATCH_HI 2 // expecting the second byte of a match
+
+void lz_init(lz_state_t *lz){
+    lz->pos = 0;
+    lz->flags = 0;
+    lz->items = 0;
+    lz->state = LZ_FLAGS;
+    lz->token_lo = 0;
+}
+
+/*
+ * Feed one byte of the compressed stream to the decoder. Any bytes it
+ * completes are written to out, which must hold LZ_MAX_MATCH bytes, and their
+ * count is returned. Returns -1 if a match reaches back before the start of
+ * the image.
+ */
+int lz_decode_byte(lz_state_t *lz, uint8_t in, uint8_t *out){
+    uint32_t token, dist, len, src;
+
+    switch (lz->state){
+    case LZ_FLAGS:
+        lz->flags = in;
+        lz->items = 8;
+        lz->state = LZ_ITEM;
+        return 0;
+
+    case LZ_ITEM:
+        if (lz->flags & 1){
+            out[0] = in;
+            lz->window[lz->pos % LZ_WINDOW_SIZE] = in;
+            lz->pos++;
+            len = 1;
+            break;
+        }
+        lz->token_lo = in;
+        lz->state = LZ_MATCH_HI;
+        return 0;
+
+    default: // LZ_MATCH_HI
+        token = lz->token_lo | ((uint32_t)in << 8);
+        dist = (token & 0x3FF) + 1;
+        len = (token >> 10) + LZ_MIN_MATCH;
+        if (dist > lz->pos){
+            return -1;
+        }
+
+        // Byte at a time, so overlapping matches repeat their own output
+        src = lz->pos - dist;
+        for (uint32_t i = 0; i < len; i++){
+            uint8_t c = lz->window[(src + i) % LZ_WINDOW_SIZE];
+            out[i] = c;
+            lz->window[lz->pos % LZ_WINDOW_SIZE] = c;
+            lz->pos++;
+        }
+        break;
+    }
+
+    // An item was completed; move on to the next one
+    lz->flags >>= 1;
+    lz->state = (--lz->items == 0) ? LZ_FLAGS : LZ_ITEM;
+    return (int)len;
+}
@@ -0,0 +1,58 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+// Application Imports
+#include "log.h"
+#include "memory.h"
+
+// Placed by bootloader.ld. Only their addresses mean anything; for the
+// sizes, the address is the value.
+extern unsigned long _arena;
+extern unsigned long _earena;
+extern unsigned long _stack;
+extern unsigned long _estack;
+extern unsigned long _esram;
+extern unsigned long BOOT_ARENA_SIZE;
+
+uint32_t stack_size(void){
+    return (uint32_t)&_estack - (uint32_t)&_stack;
+}
+
+/*
+ * Most stack used since reset, in bytes. A frame that reserves space it never
+ * writes is not seen, so leave some margin over this when sizing the stack.
+ * All of it means the stack has probably run into .bss below it.
+ */
+uint32_t stack_high_water(void){
+    const uint32_t *word = (const uint32_t *)&_stack;
+
+    while (word < (const uint32_t *)&_estack && *word == STACK_PAINT){
+        word++;
+    }
+    return (uint32_t)&_estack - (uint32_t)word;
+}
+
+uint32_t arena_size(void){
+    return (uint32_t)&BOOT_ARENA_SIZE;
+}
+
+uint32_t arena_used(void){
+    return (uint32_t)&_earena - (uint32_t)&_arena;
+}
+
+/*
+ * Log the headroom left in the memory plan on UART2, e.g. before growing a
+ * buffer for a faster protocol. Sizes are in bytes.
+ */
+void memory_report(void){
+    uint32_t used = stack_high_water();
+
+    LOG_VALUE(LOG_LEVEL_INFO, "Stack high water: ", used);
+    LOG_VALUE(LOG_LEVEL_INFO, "Stack size: ", stack_size());
+    LOG_VALUE(LOG_LEVEL_INFO, "Arena used: ", arena_used());
+    LOG_VALUE(LOG_LEVEL_INFO, "Arena size: ", arena_size());
+    LOG_VALUE(LOG_LEVEL_INFO, "SRAM unused: ", (uint32_t)&_esram - (uint32_t)&_estack);
+    if (used == stack_size()){
+        LOG(LOG_LEVEL_WARN, "Stack overflowed; raise BOOT_STACK_SIZE.\n");
+    }
+}
@@ -0,0 +1,144 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+// Library Imports
+#include <stddef.h>
+#include <string.h>
+#include "crc32.h"
+
+// Application Imports
+#include "flash_engine.h"
+#include "flash_layout.h"
+#include "metadata.h"
+
+/*
+ * The metadata is a log of records in the page at METADATA_BASE or the one
+ * at METADATA_SPARE_BASE:
+ *
+ *     [ record 0 ] [ record 1 ] ... [ erased ]
+ *
+ * Every write appends a record holding the whole metadata, so a commit is a
+ * few words programmed into erased flash instead of a page erase. A record
+ * counts once its check word, programmed last, matches; one cut short by a
+ * reset is skipped. The record with the highest sequence number is current.
+ *
+ * When the page is full the log moves to the other page: it is erased and
+ * the new record written at its start. The full page keeps the old current
+ * record until then, so there is always one to fall back on.
+ */
+#define METADATA_MAGIC 0x4154444D // "MDTA"
+#define ERASED_WORD 0xFFFFFFFF
+
+typedef struct {
+    uint32_t magic;
+    uint32_t sequence;
+    metadata_t state;
+    uint32_t check; // CRC-32 of the words before it
+} metadata_record_t;
+
+#define RECORD_WORDS (sizeof(metadata_record_t) / FLASH_WRITESIZE)
+#define RECORDS_PER_PAGE (FLASH_PAGESIZE / sizeof(metadata_record_t))
+
+// Metadata before the log: the slot words and selector at METADATA_BASE
+#define LEGACY_WORDS (SLOT_COUNT + 1)
+
+static const uint32_t log_pages[2] = {METADATA_BASE, METADATA_SPARE_BASE};
+
+static metadata_t current;
+const metadata_t * const metadata = &current;
+static uint32_t sequence;  // of the current record
+static uint32_t log_page;  // page records are appended to
+static uint32_t log_next;  // next free record in it
+
+static int record_valid(const metadata_record_t *r){
+    return r->magic == METADATA_MAGIC && r->check == crc32_update(0, r, offsetof(metadata_record_t, check));
+}
+
+static int record_erased(const metadata_record_t *r){
+    const uint32_t *words = (const uint32_t *)r;
+    for (uint32_t i = 0; i < RECORD_WORDS; i++){
+        if (words[i] != ERASED_WORD){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Find the current record. With none, metadata in the old fixed layout is
+ * taken over; the first write then starts the log in the spare page, so it
+ * stays readable until then. Otherwise every word reads as erased.
+ */
+void metadata_init(void){
+    uint32_t used[2];
+    int found = 0;
+
+    memset(&current, 0xFF, sizeof(current));
+    log_page = METADATA_BASE;
+
+    for (int p = 0; p < 2; p++){
+        const metadata_record_t *r = (const metadata_record_t *)log_pages[p];
+
+        used[p] = 0;
+        while (used[p] < RECORDS_PER_PAGE && !record_erased(&r[used[p]])){
+            if (record_valid(&r[used[p]]) && (!found || (int32_t)(r[used[p]].sequence - sequence) > 0)){
+                found = 1;
+                current = r[used[p]].state;
+                sequence = r[used[p]].sequence;
+                log_page = log_pages[p];
+            }
+            used[p]++;
+        }
+    }
+    log_next = used[(log_page == METADATA_BASE) ? 0 : 1];
+
+    const uint32_t *legacy = (const uint32_t *)METADATA_BASE;
+    if (!found && legacy[0] != METADATA_MAGIC){
+        int erased = 1;
+        for (int i = 0; i < LEGACY_WORDS; i++){
+            erased &= (legacy[i] == ERASED_WORD);
+        }
+        if (!erased){
+            for (int i = 0; i < SLOT_COUNT; i++){
+                current.slot[i] = legacy[i];
+                current.digest_word[i] = 0;
+                current.digest_type[i] = 0;
+            }
+            current.active = legacy[SLOT_COUNT];
+            log_next = RECORDS_PER_PAGE;
+        }
+    }
+}
+
+/*
+ * Make m the current metadata by appending a record, moving the log to the
+ * other page first if this one is full.
+ * Returns 0 on success and -1 if the record could not be written, in which
+ * case the metadata is unchanged.
+ */
+int metadata_write(const metadata_t *m){
+    metadata_record_t r;
+
+    r.magic = METADATA_MAGIC;
+    r.sequence = sequence + 1;
+    r.state = *m;
+    r.check = crc32_update(0, &r, offsetof(metadata_record_t, check));
+
+    if (log_next == RECORDS_PER_PAGE){
+        log_page = (log_page == METADATA_BASE) ? METADATA_SPARE_BASE : METADATA_BASE;
+        log_next = 0;
+        if (flash_erase_sync(log_page)){
+            return -1;
+        }
+    }
+
+    // The slot is used up even if programming fails part way
+    const metadata_record_t *dest = (const metadata_record_t *)log_page + log_next++;
+    if (flash_program_sync((uint32_t)dest, (const uint32_t *)&r, RECORD_WORDS) || !record_valid(dest)){
+        return -1;
+    }
+
+    current = *m;
+    sequence = r.sequence;
+    return 0;
+}
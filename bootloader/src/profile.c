@@ -0,0 +1,154 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+// Driver API Imports
+#include "driverlib/systick.h" // SysTick API
+
+// Library Imports
+#include <string.h>
+
+// Application Imports
+#include "memory.h"
+#include "profile.h"
+
+// SysTick counts down through 24 bits; its interrupt extends that to 64.
+#define PROFILE_TICK_BITS 24
+#define PROFILE_TICK_MASK ((1UL << PROFILE_TICK_BITS) - 1)
+
+static volatile uint32_t tick_wraps;
+static uint64_t cycle_base; // rescales what was counted at an earlier clock
+static uint64_t phase_start;
+static uint8_t current_phase = PROFILE_NONE;
+static uint64_t phase_cycles[PROFILE_PHASES];
+static uint32_t page_cycles[PROFILE_MAX_PAGES] ARENA;
+static uint32_t page_count;
+
+void SysTick_Handler(void){
+    tick_wraps++;
+}
+
+/*
+ * Start SysTick as a free running cycle counter.
+ */
+void profile_init(void){
+    tick_wraps = 0;
+    cycle_base = 0;
+    SysTickPeriodSet(PROFILE_TICK_MASK + 1);
+    SysTickIntEnable();
+    SysTickEnable();
+}
+
+/*
+ * Stop the wrap interrupt before handing off to firmware. The counter keeps
+ * running so the firmware can carry on timing its startup with it.
+ */
+void profile_disable(void){
+    SysTickIntDisable();
+}
+
+/*
+ * Cycles of the current clock since profile_init(). Must not be called with
+ * interrupts masked, or after profile_disable(), or a wrap would be missed.
+ */
+uint64_t profile_cycles(void){
+    uint32_t wraps;
+    uint32_t value;
+
+    do {
+        wraps = tick_wraps;
+        value = SysTickValueGet();
+    } while (wraps != tick_wraps);
+
+    return ((uint64_t)wraps << PROFILE_TICK_BITS) + (PROFILE_TICK_MASK - value) + cycle_base;
+}
+
+/*
+ * Convert cycles of a from_hz clock to cycles of a to_hz one.
+ */
+uint64_t profile_scale(uint64_t cycles, uint32_t from_hz, uint32_t to_hz){
+    if (from_hz == to_hz){
+        return cycles;
+    }
+    return (cycles / from_hz) * to_hz + (cycles % from_hz) * to_hz / from_hz;
+}
+
+/*
+ * Follow a change of the system clock from from_hz to to_hz. Everything
+ * counted so far is rescaled, so the count and the profile stay in cycles
+ * of the current clock rather than mixing the two rates.
+ */
+void profile_clock(uint32_t from_hz, uint32_t to_hz){
+    uint64_t now = profile_cycles();
+
+    cycle_base += profile_scale(now, from_hz, to_hz) - now;
+    phase_start = profile_scale(phase_start, from_hz, to_hz);
+    for (int i = 0; i < PROFILE_PHASES; i++){
+        phase_cycles[i] = profile_scale(phase_cycles[i], from_hz, to_hz);
+    }
+    for (uint32_t i = 0; i < page_count; i++){
+        page_cycles[i] = (uint32_t)profile_scale(page_cycles[i], from_hz, to_hz);
+    }
+}
+
+/*
+ * Clear the profile and start charging time to phase.
+ */
+void profile_start(uint8_t phase){
+    memset(phase_cycles, 0, sizeof(phase_cycles));
+    memset(page_cycles, 0, sizeof(page_cycles));
+    page_count = 0;
+    current_phase = PROFILE_NONE;
+    profile_enter(phase);
+}
+
+/*
+ * Stop charging time; the profile is kept until the next profile_start().
+ */
+void profile_end(void){
+    profile_enter(PROFILE_NONE);
+}
+
+/*
+ * Charge the time since the last switch to the running phase and move on to
+ * phase. Returns the phase that was running, to be entered again after a
+ * nested step.
+ */
+uint8_t profile_enter(uint8_t phase){
+    uint64_t now = profile_cycles();
+    uint8_t previous = current_phase;
+
+    if (previous < PROFILE_PHASES){
+        phase_cycles[previous] += now - phase_start;
+    }
+    phase_start = now;
+    current_phase = phase;
+    return previous;
+}
+
+/*
+ * Add cycles spent writing the flash page at page_addr. Pages are counted
+ * from the start of whichever slot holds them.
+ */
+void profile_page(uint32_t page_addr, uint32_t cycles){
+    uint32_t page = ((page_addr - FW_BASE) % SLOT_SIZE) / FLASH_PAGESIZE;
+
+    page_cycles[page] += cycles;
+    if (page >= page_count){
+        page_count = page + 1;
+    }
+}
+
+uint64_t profile_phase_cycles(uint8_t phase){
+    return phase_cycles[phase];
+}
+
+uint32_t profile_page_cycles(uint32_t page){
+    return page_cycles[page];
+}
+
+/*
+ * One past the highest page written since profile_start().
+ */
+uint32_t profile_pages(void){
+    return page_count;
+}
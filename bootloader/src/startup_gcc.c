@@ -37,6 +37,8 @@
 //
 //*****************************************************************************
 
+#include "memory.h"
+
 //*****************************************************************************
 //
 // Forward declaration of the default fault handlers.
@@ -58,6 +60,10 @@ static void IntDefaultHandler(void);
 //
 //******************************************************************************
 extern void UART0_IRQHandler(void);
+extern void UART1_IRQHandler(void);
+extern void UART2_IRQHandler(void);
+extern void SysTick_Handler(void);
+extern void FLASH_IRQHandler(void);
 
 
 
@@ -71,10 +77,12 @@ extern int main(void);
 
 //*****************************************************************************
 //
-// Reserve space for the system stack.
+// The system stack is reserved by the linker script, past the end of .bss
+// (see bootloader.ld).
 //
 //*****************************************************************************
-static unsigned long pulStack[64];
+extern unsigned long _stack;
+extern unsigned long _estack;
 
 //*****************************************************************************
 //
@@ -85,7 +93,7 @@ static unsigned long pulStack[64];
 __attribute__ ((section(".isr_vector")))
 void (* const g_pfnVectors[])(void) =
 {
-    (void (*)(void))((unsigned long)pulStack + sizeof(pulStack)),
+    (void (*)(void))((unsigned long)&_estack),
                                             // The initial stack pointer
     ResetISR,                               // The reset handler
     NmiSR,                                  // The NMI handler
@@ -101,14 +109,14 @@ void (* const g_pfnVectors[])(void) =
     IntDefaultHandler,                      // Debug monitor handler
     0,                                      // Reserved
     IntDefaultHandler,                      // The PendSV handler
-    IntDefaultHandler,                      // The SysTick handler
+    SysTick_Handler,                        // The SysTick handler
     IntDefaultHandler,                      // GPIO Port A
     IntDefaultHandler,                      // GPIO Port B
     IntDefaultHandler,                      // GPIO Port C
     IntDefaultHandler,                      // GPIO Port D
     IntDefaultHandler,                      // GPIO Port E
     UART0_IRQHandler,                      // UART0 Rx and Tx
-    IntDefaultHandler,                      // UART1 Rx and Tx
+    UART1_IRQHandler,                       // UART1 Rx and Tx
     IntDefaultHandler,                      // SSI0 Rx and Tx
     IntDefaultHandler,                      // I2C0 Master and Slave
     IntDefaultHandler,                      // PWM Fault
@@ -131,11 +139,11 @@ void (* const g_pfnVectors[])(void) =
     IntDefaultHandler,                      // Analog Comparator 1
     IntDefaultHandler,                      // Analog Comparator 2
     IntDefaultHandler,                      // System Control (PLL, OSC, BO)
-    IntDefaultHandler,                      // FLASH Control
+    FLASH_IRQHandler,                       // FLASH Control
     IntDefaultHandler,                      // GPIO Port F
     IntDefaultHandler,                      // GPIO Port G
     IntDefaultHandler,                      // GPIO Port H
-    IntDefaultHandler,                      // UART2 Rx and Tx
+    UART2_IRQHandler,                       // UART2 Rx and Tx
     IntDefaultHandler,                      // SSI1 Rx and Tx
     IntDefaultHandler,                      // Timer 3 subtimer A
     IntDefaultHandler,                      // Timer 3 subtimer B
@@ -172,6 +180,89 @@ extern unsigned long _edata;
 extern unsigned long _bss;
 extern unsigned long _ebss;
 
+//*****************************************************************************
+//
+// Copy words from pulSrc to pulDest until pulDest reaches pulEnd, eight at a
+// time with LDM/STM and then one at a time. Inlined, so that ResetISR uses
+// as little stack as possible before it is painted.
+//
+//*****************************************************************************
+static inline __attribute__((always_inline)) void
+CopyWords(unsigned long *pulDest, unsigned long *pulSrc, unsigned long *pulEnd)
+{
+    unsigned long ulLeft;
+
+    __asm volatile("1:  sub     %2, %3, %0\n"
+                   "    cmp     %2, #32\n"
+                   "    blt     2f\n"
+                   "    ldmia   %1!, {r3-r6, r8-r10, r12}\n"
+                   "    stmia   %0!, {r3-r6, r8-r10, r12}\n"
+                   "    b       1b\n"
+                   "2:  cmp     %0, %3\n"
+                   "    ittt    lt\n"
+                   "    ldrlt   r3, [%1], #4\n"
+                   "    strlt   r3, [%0], #4\n"
+                   "    blt     2b\n"
+                   : "+r" (pulDest), "+r" (pulSrc), "=&r" (ulLeft)
+                   : "r" (pulEnd)
+                   : "r3", "r4", "r5", "r6", "r8", "r9", "r10", "r12", "cc",
+                     "memory");
+}
+
+//*****************************************************************************
+//
+// Zero words from pulDest until pulEnd, eight at a time with STM and then one
+// at a time.
+//
+//*****************************************************************************
+static inline __attribute__((always_inline)) void
+ZeroWords(unsigned long *pulDest, unsigned long *pulEnd)
+{
+    unsigned long ulLeft;
+
+    __asm volatile("    movs    r3, #0\n"
+                   "    mov     r4, r3\n"
+                   "    mov     r5, r3\n"
+                   "    mov     r6, r3\n"
+                   "    mov     r8, r3\n"
+                   "    mov     r9, r3\n"
+                   "    mov     r10, r3\n"
+                   "    mov     r12, r3\n"
+                   "1:  sub     %1, %2, %0\n"
+                   "    cmp     %1, #32\n"
+                   "    blt     2f\n"
+                   "    stmia   %0!, {r3-r6, r8-r10, r12}\n"
+                   "    b       1b\n"
+                   "2:  cmp     %0, %2\n"
+                   "    itt     lt\n"
+                   "    strlt   r3, [%0], #4\n"
+                   "    blt     2b\n"
+                   : "+r" (pulDest), "=&r" (ulLeft)
+                   : "r" (pulEnd)
+                   : "r3", "r4", "r5", "r6", "r8", "r9", "r10", "r12", "cc",
+                     "memory");
+}
+
+//*****************************************************************************
+//
+// Fill the stack from pulDest up to the stack pointer with ulPaint, so the
+// deepest use can be found later (see memory.c). Written in assembly so that
+// nothing is pushed below the stack pointer while it is being painted.
+//
+//*****************************************************************************
+static inline __attribute__((always_inline)) void
+PaintStack(unsigned long *pulDest, unsigned long ulPaint)
+{
+    __asm volatile("    mov     r3, sp\n"
+                   "1:  cmp     %0, r3\n"
+                   "    itt     lo\n"
+                   "    strlo   %1, [%0], #4\n"
+                   "    blo     1b\n"
+                   : "+r" (pulDest)
+                   : "r" (ulPaint)
+                   : "r3", "cc", "memory");
+}
+
 //*****************************************************************************
 //
 // This is the code that gets called when the processor first starts execution
@@ -185,29 +276,20 @@ extern unsigned long _ebss;
 void
 ResetISR(void)
 {
-    unsigned long *pulSrc, *pulDest;
-
     //
     // Copy the data segment initializers from flash to SRAM.
     //
-    pulSrc = &_etext;
-    for(pulDest = &_data; pulDest < &_edata; )
-    {
-        *pulDest++ = *pulSrc++;
-    }
+    CopyWords(&_data, &_etext, &_edata);
 
     //
     // Zero fill the bss segment.
     //
-    __asm("    ldr     r0, =_bss\n"
-          "    ldr     r1, =_ebss\n"
-          "    mov     r2, #0\n"
-          "    .thumb_func\n"
-          "zero_loop:\n"
-          "        cmp     r0, r1\n"
-          "        it      lt\n"
-          "        strlt   r2, [r0], #4\n"
-          "        blt     zero_loop");
+    ZeroWords(&_bss, &_ebss);
+
+    //
+    // Paint the stack below the one frame in use, for the high-water mark.
+    //
+    PaintStack(&_stack, STACK_PAINT);
 
     //
     // Call the application's entry point.
@@ -0,0 +1,132 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+// Hardware Imports
+#include "inc/hw_memmap.h" // Peripheral Base Addresses
+#include "inc/hw_types.h"  // Boolean type
+#include "inc/hw_ints.h"   // Interrupt numbers
+
+// Driver API Imports
+#include "driverlib/interrupt.h" // Interrupt API
+#include "driverlib/sysctl.h"    // System control API (clock/reset)
+#include "driverlib/uart.h"      // UART API
+
+// Application Imports
+#include "memory.h"
+#include "ring_buffer.h"
+#include "uart_rx.h"
+
+static uint8_t rx_storage[UART_RX_BUFFER_SIZE] ARENA;
+static ring_buffer_t rx_ring = RING_INIT(rx_storage);
+static volatile uint32_t rx_overruns = 0;
+static uint32_t rx_baud = UART_DEFAULT_BAUD;
+
+/*
+ * Drain the UART1 hardware FIFO into the receive ring. Fires when the FIFO
+ * reaches its trigger level or when a partial FIFO has been idle (receive
+ * timeout), so bytes never sit in hardware long enough to be overrun.
+ */
+void UART1_IRQHandler(void){
+    uint32_t status = UARTIntStatus(UART1_BASE, true);
+    UARTIntClear(UART1_BASE, status);
+
+    while (UARTCharsAvail(UART1_BASE)){
+        uint8_t c = (uint8_t)UARTCharGetNonBlocking(UART1_BASE);
+        if (ring_put(&rx_ring, c)){
+            rx_overruns++;
+        }
+    }
+}
+
+/*
+ * Start interrupt driven reception. uart_init(UART1) must have been called.
+ */
+void uart_rx_init(void){
+    UARTFIFOLevelSet(UART1_BASE, UART_FIFO_TX4_8, UART_FIFO_RX4_8);
+    UARTIntEnable(UART1_BASE, UART_INT_RX | UART_INT_RT);
+    IntEnable(INT_UART1);
+}
+
+/*
+ * Stop interrupt driven reception, e.g. before handing off to firmware.
+ */
+void uart_rx_disable(void){
+    IntDisable(INT_UART1);
+    UARTIntDisable(UART1_BASE, UART_INT_RX | UART_INT_RT);
+}
+
+/*
+ * Block until a byte has been received and return it.
+ */
+uint8_t uart_rx_getc(void){
+    uint8_t c;
+    while (ring_get(&rx_ring, &c)){
+    }
+    return c;
+}
+
+/*
+ * Wait up to timeout_ms milliseconds for a byte.
+ * Returns 0 with the byte in c, or -1 if none arrived in time.
+ */
+int uart_rx_getc_timeout(uint8_t *c, uint32_t timeout_ms){
+    for (uint32_t waited = 0; ; waited++){
+        if (ring_get(&rx_ring, c) == 0){
+            return 0;
+        }
+        if (waited == timeout_ms){
+            return -1;
+        }
+        SysCtlDelay(SysCtlClockGet() / 3000); // three cycles per loop
+    }
+}
+
+/*
+ * Discard received bytes until the line has been quiet for idle_ms
+ * milliseconds. Used before a reset so that frames the host still had in
+ * flight are not mistaken for commands once the bootloader restarts.
+ */
+void uart_rx_drain(uint32_t idle_ms){
+    uint32_t quiet = 0;
+    uint8_t c;
+
+    while (quiet < idle_ms){
+        SysCtlDelay(SysCtlClockGet() / 3000); // three cycles per loop
+        if (ring_get(&rx_ring, &c) == 0){
+            while (ring_get(&rx_ring, &c) == 0){
+            }
+            quiet = 0;
+        }else{
+            quiet++;
+        }
+    }
+}
+
+uint32_t uart_rx_available(void){
+    return ring_count(&rx_ring);
+}
+
+uint32_t uart_rx_overruns(void){
+    return rx_overruns;
+}
+
+/*
+ * Reconfigure UART1 for a new baud rate. The UART needs 16 clocks per bit,
+ * so rates above a sixteenth of the system clock are refused (-1). Anything
+ * still being transmitted is sent at the old rate first.
+ */
+int uart_rx_set_baud(uint32_t baud){
+    if (baud == 0 || baud > SysCtlClockGet() / 16){
+        return -1;
+    }
+
+    // Disables the UART once idle, then enables it again with the FIFOs on
+    UARTConfigSetExpClk(UART1_BASE, SysCtlClockGet(), baud,
+                        UART_CONFIG_WLEN_8 | UART_CONFIG_STOP_ONE | UART_CONFIG_PAR_NONE);
+    rx_baud = baud;
+    return 0;
+}
+
+uint32_t uart_rx_baud(void){
+    return rx_baud;
+}
@@ -0,0 +1,292 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+// Microbenchmarks for firmware/lib, built natively against mock_uart.c.
+// Every benchmark runs a fixed number of iterations REPEATS times, so
+// results are comparable run to run; the median and best ns per operation
+// are printed as JSON. Name substrings on the command line pick benchmarks:
+//
+//     ./build/bench readLine hex2str
+
+#include "mock_uart.h"
+#include "mitre_car.h"
+#include "usart.h"
+#include "util.h"
+#include "uart.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define REPEATS 7
+
+typedef struct
+{
+    const char *name;
+    long iterations;
+    long bytes; // bytes processed per operation, 0 if not meaningful
+    void (*run)(long iterations);
+} benchmark_t;
+
+static char line[256];
+static char hex[2048 + 1];
+static char bytes[1024];
+
+// The application commands live in firmware/src, which is not part of the
+// host build; the command table still refers to them.
+void flagCommand(char *buffer)
+{
+    writeLine("FLAG");
+}
+
+void statsCommand(char *buffer)
+{
+    writeLine("STATS");
+}
+
+//
+// Benchmarks
+//
+
+static const char *const hit_commands[] = { "EMISSIONS", "SAFETY", "INFOTAINMENT", "SECURITY", "HELP" };
+#define HIT_COMMANDS (sizeof(hit_commands) / sizeof(hit_commands[0]))
+
+static void parseCommandHit(long iterations)
+{
+    long i;
+    for(i = 0; i < iterations; ++i)
+    {
+        const char *command = hit_commands[i % HIT_COMMANDS];
+        int len = strlen(command);
+        memcpy(line, command, len + 1);
+        parseCommand(line, len);
+    }
+}
+
+static void parseCommandMiss(long iterations)
+{
+    long i;
+    for(i = 0; i < iterations; ++i)
+    {
+        memcpy(line, "EMISSION", sizeof("EMISSION"));
+        parseCommand(line, sizeof("EMISSION") - 1);
+    }
+}
+
+static void readLineOf(const char *text, long iterations)
+{
+    int len = strlen(text);
+    long i;
+    for(i = 0; i < iterations; ++i)
+    {
+        mockUartReceive(UART2, text, len);
+        readLine(line, sizeof(line));
+    }
+}
+
+static void readLineShort(long iterations)
+{
+    readLineOf("SECURITY\r\n", iterations);
+}
+
+static char long_line[201];
+
+static void readLineLong(long iterations)
+{
+    readLineOf(long_line, iterations);
+}
+
+static void str2hex64(long iterations)
+{
+    long i;
+    for(i = 0; i < iterations; ++i)
+    {
+        str2hex(bytes, 64, hex);
+    }
+}
+
+static void str2hex1024(long iterations)
+{
+    long i;
+    for(i = 0; i < iterations; ++i)
+    {
+        str2hex(bytes, 1024, hex);
+    }
+}
+
+static void hex2str64(long iterations)
+{
+    long i;
+    for(i = 0; i < iterations; ++i)
+    {
+        hex2str(hex, 128, bytes);
+    }
+}
+
+static void hex2str1024(long iterations)
+{
+    long i;
+    for(i = 0; i < iterations; ++i)
+    {
+        hex2str(hex, 2048, bytes);
+    }
+}
+
+static void printBannerOnce(long iterations)
+{
+    long i;
+    for(i = 0; i < iterations; ++i)
+    {
+        printBanner();
+    }
+}
+
+static void helpOnce(long iterations)
+{
+    long i;
+    for(i = 0; i < iterations; ++i)
+    {
+        memcpy(line, "HELP", sizeof("HELP"));
+        parseCommand(line, sizeof("HELP") - 1);
+    }
+}
+
+static const benchmark_t benchmarks[] = {
+    { "parseCommand/hit", 200000, 0, parseCommandHit },
+    { "parseCommand/miss", 200000, 0, parseCommandMiss },
+    { "readLine/short", 500000, 10, readLineShort },
+    { "readLine/long", 50000, 200, readLineLong },
+    { "str2hex/64", 1000000, 64, str2hex64 },
+    { "str2hex/1024", 100000, 1024, str2hex1024 },
+    { "hex2str/64", 1000000, 64, hex2str64 },
+    { "hex2str/1024", 100000, 1024, hex2str1024 },
+    { "printBanner", 20000, 1263, printBannerOnce },
+    { "help", 100000, 315, helpOnce },
+};
+#define BENCHMARKS (sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+//
+// Harness
+//
+
+static void setup(void)
+{
+    int i;
+
+    mockUartReset();
+    initializeShell();
+
+    for(i = 0; i < (int)sizeof(bytes); ++i)
+    {
+        bytes[i] = i * 131 + 7;
+    }
+    str2hex(bytes, sizeof(bytes), hex);
+    hex[sizeof(hex) - 1] = '\0';
+
+    memset(long_line, 'x', sizeof(long_line) - 2);
+    long_line[sizeof(long_line) - 2] = '\n';
+    long_line[sizeof(long_line) - 1] = '\0';
+}
+
+// Make sure the code under test does what the benchmarks assume, so a
+// broken build fails loudly rather than timing the wrong thing.
+static int selfCheck(void)
+{
+    char captured[64];
+    char decoded[sizeof(bytes)];
+    unsigned long sent;
+    int len;
+
+    mockUartReceive(UART2, "SAFETY\r\n", 8);
+    if(readLine(line, sizeof(line)) != 6 || strcmp(line, "SAFETY") != 0) return 1;
+
+    sent = mockUartSent(UART2);
+    parseCommand(line, 6);
+    len = mockUartCaptured(UART2, captured, sizeof(captured));
+    if(mockUartSent(UART2) - sent != sizeof("System normal.\n") - 1) return 2;
+    if(memcmp(captured + len - 15, "System normal.\n", 15) != 0) return 2;
+
+    if(hex2str(hex, sizeof(hex) - 1, decoded) != (int)sizeof(bytes)) return 3;
+    if(memcmp(decoded, bytes, sizeof(bytes)) != 0) return 3;
+
+    // The banner is decoded from the compressed text table.
+    sent = mockUartSent(UART2);
+    printBanner();
+    len = mockUartCaptured(UART2, captured, sizeof(captured));
+    if(mockUartSent(UART2) - sent != 1263) return 4;
+    if(memcmp(captured + len - 3, " \n\n", 3) != 0) return 4;
+
+    return 0;
+}
+
+static double nsSince(const struct timespec *start)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) * 1e9 + (end.tv_nsec - start->tv_nsec);
+}
+
+static int compareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static int selected(const char *name, int argc, char **argv)
+{
+    int i;
+    if(argc < 2) return 1;
+    for(i = 1; i < argc; ++i)
+    {
+        if(strstr(name, argv[i])) return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *separator = "";
+    unsigned int b;
+    int failed;
+
+    setup();
+    failed = selfCheck();
+    if(failed)
+    {
+        fprintf(stderr, "self-check %d failed\n", failed);
+        return 1;
+    }
+
+    printf("{\n  \"suite\": \"firmware/lib\",\n  \"repeats\": %d,\n  \"benchmarks\": [", REPEATS);
+    for(b = 0; b < BENCHMARKS; ++b)
+    {
+        const benchmark_t *bench = &benchmarks[b];
+        double ns[REPEATS];
+        int r;
+
+        if(!selected(bench->name, argc, argv)) continue;
+
+        // One untimed pass to warm caches and branch predictors.
+        bench->run(bench->iterations / 10 + 1);
+        for(r = 0; r < REPEATS; ++r)
+        {
+            struct timespec start;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            bench->run(bench->iterations);
+            ns[r] = nsSince(&start) / bench->iterations;
+        }
+        qsort(ns, REPEATS, sizeof(ns[0]), compareDoubles);
+
+        printf("%s\n    {\"name\": \"%s\", \"iterations\": %ld, \"ns_per_op\": %.2f, \"min_ns_per_op\": %.2f",
+               separator, bench->name, bench->iterations, ns[REPEATS / 2], ns[0]);
+        if(bench->bytes)
+        {
+            printf(", \"bytes_per_op\": %ld, \"mb_per_s\": %.1f", bench->bytes, bench->bytes * 1e3 / ns[REPEATS / 2]);
+        }
+        printf("}");
+        separator = ",";
+    }
+    printf("\n  ]\n}\n");
+    return 0;
+}
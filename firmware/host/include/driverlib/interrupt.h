@@ -0,0 +1,13 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+// Host stand-in for driverlib/interrupt.h. Masking is tracked per UART so
+// mock_uart.c only raises an interrupt while it is enabled.
+
+#ifndef __INTERRUPT_H__
+#define __INTERRUPT_H__
+
+void IntEnable(unsigned long ulInterrupt);
+void IntDisable(unsigned long ulInterrupt);
+
+#endif
@@ -0,0 +1,29 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+// Host stand-in for the parts of driverlib/uart.h the firmware uses,
+// implemented in mock_uart.c.
+
+#ifndef __UART_H__
+#define __UART_H__
+
+#include "inc/hw_types.h"
+
+#define UART_INT_RT 0x040
+#define UART_INT_TX 0x020
+#define UART_INT_RX 0x010
+
+#define UART_FIFO_TX4_8 0x00000002
+#define UART_FIFO_RX4_8 0x00000010
+
+void UARTFIFOLevelSet(unsigned long ulBase, unsigned long ulTxLevel, unsigned long ulRxLevel);
+tBoolean UARTCharsAvail(unsigned long ulBase);
+tBoolean UARTSpaceAvail(unsigned long ulBase);
+long UARTCharGetNonBlocking(unsigned long ulBase);
+tBoolean UARTCharPutNonBlocking(unsigned long ulBase, unsigned char ucData);
+tBoolean UARTBusy(unsigned long ulBase);
+void UARTIntEnable(unsigned long ulBase, unsigned long ulIntFlags);
+unsigned long UARTIntStatus(unsigned long ulBase, tBoolean bMasked);
+void UARTIntClear(unsigned long ulBase, unsigned long ulIntFlags);
+
+#endif
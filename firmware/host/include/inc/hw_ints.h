@@ -0,0 +1,13 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+// Host stand-in for the Stellaris inc/hw_ints.h.
+
+#ifndef HW_INTS_H
+#define HW_INTS_H
+
+#define INT_UART0 21
+#define INT_UART1 22
+#define INT_UART2 49
+
+#endif
@@ -0,0 +1,14 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+// Host stand-in for the Stellaris inc/hw_memmap.h. The UART bases only
+// select a port in mock_uart.c.
+
+#ifndef HW_MEMMAP_H
+#define HW_MEMMAP_H
+
+#define UART0_BASE 0x4000C000
+#define UART1_BASE 0x4000D000
+#define UART2_BASE 0x4000E000
+
+#endif
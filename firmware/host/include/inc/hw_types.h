@@ -0,0 +1,19 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+// Host stand-in for the Stellaris inc/hw_types.h.
+
+#ifndef HW_TYPES_H
+#define HW_TYPES_H
+
+typedef unsigned char tBoolean;
+
+#ifndef true
+#define true 1
+#endif
+
+#ifndef false
+#define false 0
+#endif
+
+#endif
@@ -0,0 +1,26 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+// Host stand-in for the embsec UART library, backed by the in-memory ports
+// in mock_uart.c.
+
+#ifndef UART_H
+#define UART_H
+
+#include <stdint.h>
+
+#define UART0 0
+#define UART1 1
+#define UART2 2
+
+#define BLOCKING 1
+#define NONBLOCKING 0
+
+void uart_init(uint8_t uart);
+uint32_t uart_read(uint8_t uart, int blocking, int *read);
+void uart_write(uint8_t uart, uint32_t data);
+void uart_write_str(uint8_t uart, char *str);
+void nl(uint8_t uart);
+void uart_write_hex(uint8_t uart, uint32_t data);
+
+#endif
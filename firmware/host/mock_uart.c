@@ -0,0 +1,231 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+#include "mock_uart.h"
+#include "uart.h"
+
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "inc/hw_ints.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/uart.h"
+
+#include <string.h>
+
+typedef struct
+{
+    unsigned char rx[MOCK_UART_RX_SIZE];
+    unsigned int rx_head;
+    unsigned int rx_tail;
+    char capture[MOCK_UART_CAPTURE_SIZE];
+    unsigned long sent;
+    unsigned long int_flags;
+    int masked;
+} mock_uart_t;
+
+static mock_uart_t ports[MOCK_UART_PORTS];
+
+// The UART entries of the firmware's vector table
+extern void UART2_IRQHandler(void);
+static void (*const handlers[MOCK_UART_PORTS])(void) = { 0, 0, UART2_IRQHandler };
+
+static mock_uart_t *portForBase(unsigned long base)
+{
+    return &ports[(base - UART0_BASE) >> 12];
+}
+
+static mock_uart_t *portForInterrupt(unsigned long interrupt)
+{
+    switch(interrupt)
+    {
+    case INT_UART0: return &ports[UART0];
+    case INT_UART1: return &ports[UART1];
+    case INT_UART2: return &ports[UART2];
+    default: return 0;
+    }
+}
+
+static void transmit(mock_uart_t *port, unsigned char c)
+{
+    port->capture[port->sent % MOCK_UART_CAPTURE_SIZE] = c;
+    port->sent++;
+}
+
+void mockUartReset(void)
+{
+    memset(ports, 0, sizeof(ports));
+}
+
+int mockUartReceive(int port_number, const char *data, int len)
+{
+    mock_uart_t *port = &ports[port_number];
+    int queued;
+
+    for(queued = 0; queued < len; ++queued)
+    {
+        unsigned int next = (port->rx_head + 1) % MOCK_UART_RX_SIZE;
+        if(next == port->rx_tail)
+        {
+            break;
+        }
+        port->rx[port->rx_head] = data[queued];
+        port->rx_head = next;
+    }
+
+    if(handlers[port_number] && !port->masked && (port->int_flags & (UART_INT_RX | UART_INT_RT)))
+    {
+        handlers[port_number]();
+    }
+    return queued;
+}
+
+unsigned long mockUartSent(int port)
+{
+    return ports[port].sent;
+}
+
+int mockUartCaptured(int port_number, char *buffer, int max)
+{
+    mock_uart_t *port = &ports[port_number];
+    unsigned long available = port->sent < MOCK_UART_CAPTURE_SIZE ? port->sent : MOCK_UART_CAPTURE_SIZE;
+    int len = available < (unsigned long)max ? (int)available : max;
+    unsigned long start = port->sent - len;
+    int i;
+
+    for(i = 0; i < len; ++i)
+    {
+        buffer[i] = port->capture[(start + i) % MOCK_UART_CAPTURE_SIZE];
+    }
+    return len;
+}
+
+//
+// uart.h
+//
+
+void uart_init(uint8_t uart)
+{
+}
+
+uint32_t uart_read(uint8_t uart, int blocking, int *read)
+{
+    mock_uart_t *port = &ports[uart];
+
+    // Nothing else can fill the FIFO on the host, so a blocking read of an
+    // empty port fails rather than hangs.
+    if(port->rx_tail == port->rx_head)
+    {
+        *read = 0;
+        return 0;
+    }
+    *read = 1;
+    uint32_t c = port->rx[port->rx_tail];
+    port->rx_tail = (port->rx_tail + 1) % MOCK_UART_RX_SIZE;
+    return c;
+}
+
+void uart_write(uint8_t uart, uint32_t data)
+{
+    transmit(&ports[uart], data);
+}
+
+void uart_write_str(uint8_t uart, char *str)
+{
+    for(; *str != '\0'; ++str)
+    {
+        transmit(&ports[uart], *str);
+    }
+}
+
+void nl(uint8_t uart)
+{
+    transmit(&ports[uart], '\n');
+}
+
+void uart_write_hex(uint8_t uart, uint32_t data)
+{
+    char hex[11] = "0x";
+    int i;
+
+    for(i = 0; i < 8; ++i)
+    {
+        hex[2 + i] = "0123456789abcdef"[(data >> (28 - 4 * i)) & 0xF];
+    }
+    hex[10] = '\0';
+    uart_write_str(uart, hex);
+}
+
+//
+// driverlib
+//
+
+void IntEnable(unsigned long interrupt)
+{
+    mock_uart_t *port = portForInterrupt(interrupt);
+    if(port)
+    {
+        port->masked = 0;
+    }
+}
+
+void IntDisable(unsigned long interrupt)
+{
+    mock_uart_t *port = portForInterrupt(interrupt);
+    if(port)
+    {
+        port->masked = 1;
+    }
+}
+
+void UARTFIFOLevelSet(unsigned long base, unsigned long tx_level, unsigned long rx_level)
+{
+}
+
+tBoolean UARTCharsAvail(unsigned long base)
+{
+    mock_uart_t *port = portForBase(base);
+    return port->rx_tail != port->rx_head;
+}
+
+tBoolean UARTSpaceAvail(unsigned long base)
+{
+    return true;
+}
+
+long UARTCharGetNonBlocking(unsigned long base)
+{
+    mock_uart_t *port = portForBase(base);
+    if(port->rx_tail == port->rx_head)
+    {
+        return -1;
+    }
+    long c = port->rx[port->rx_tail];
+    port->rx_tail = (port->rx_tail + 1) % MOCK_UART_RX_SIZE;
+    return c;
+}
+
+tBoolean UARTCharPutNonBlocking(unsigned long base, unsigned char data)
+{
+    transmit(portForBase(base), data);
+    return true;
+}
+
+tBoolean UARTBusy(unsigned long base)
+{
+    return false;
+}
+
+void UARTIntEnable(unsigned long base, unsigned long flags)
+{
+    portForBase(base)->int_flags |= flags;
+}
+
+unsigned long UARTIntStatus(unsigned long base, tBoolean masked)
+{
+    mock_uart_t *port = portForBase(base);
+    return port->rx_tail != port->rx_head ? (port->int_flags & UART_INT_RX) : 0;
+}
+
+void UARTIntClear(unsigned long base, unsigned long flags)
+{
+}
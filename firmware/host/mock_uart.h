@@ -0,0 +1,28 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+#ifndef MOCK_UART_H
+#define MOCK_UART_H
+
+// In-memory UARTs behind the host build's uart.h and driverlib stand-ins.
+// Each port has a receive FIFO the test side fills and a transmit capture
+// it reads back; transmission is instantaneous, so the TX FIFO never fills.
+// Ports are numbered like uart.h (UART0..UART2).
+#define MOCK_UART_PORTS 3
+#define MOCK_UART_RX_SIZE 4096
+#define MOCK_UART_CAPTURE_SIZE 4096
+
+void mockUartReset(void);
+
+// Queue bytes as if they had arrived on the wire, then run the port's
+// vector table handler (if its interrupt is enabled) the way the receive
+// interrupt would. Returns the number of bytes queued; the rest are dropped
+// like an overrun.
+int mockUartReceive(int port, const char *data, int len);
+
+// Total bytes transmitted on a port since the last reset, and the most
+// recent of them (up to MOCK_UART_CAPTURE_SIZE, oldest first).
+unsigned long mockUartSent(int port);
+int mockUartCaptured(int port, char *buffer, int max);
+
+#endif
@@ -0,0 +1,38 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+// Generated by tools/gen_commands.py from lib/commands.def, src/commands.def.
+// Do not edit; change the .def files and rebuild.
+
+#ifndef COMMAND_TABLE_H
+#define COMMAND_TABLE_H
+
+#include "commands.h"
+
+#define COMMAND_COUNT 7
+#define COMMAND_BUCKETS 4
+#define COMMAND_SLOTS 8
+
+void emissionsCommand(char *buffer);
+void flagCommand(char *buffer);
+void helpCommand(char *buffer);
+void infotainmentCommand(char *buffer);
+void safetyCommand(char *buffer);
+void securityCommand(char *buffer);
+void statsCommand(char *buffer);
+
+static const uint16_t command_displacement[COMMAND_BUCKETS] = {
+    1, 1, 3, 1,
+};
+
+static const command_t command_table[COMMAND_SLOTS] = {
+    [0] = { "SECURITY", 8, securityCommand },
+    [1] = { "EMISSIONS", 9, emissionsCommand },
+    [2] = { "HELP", 4, helpCommand },
+    [4] = { "FLAG", 4, flagCommand },
+    [5] = { "STATS", 5, statsCommand },
+    [6] = { "SAFETY", 6, safetyCommand },
+    [7] = { "INFOTAINMENT", 12, infotainmentCommand },
+};
+
+#endif
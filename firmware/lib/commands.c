@@ -0,0 +1,42 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+#include "commands.h"
+#include "command_table.h"
+
+#include <string.h>
+
+#define FNV_BASIS 0x811C9DC5
+#define FNV_PRIME 0x01000193
+
+// 32-bit FNV-1a seeded through the offset basis, with the high half folded
+// into the low bits the table index is taken from; must match
+// command_hash() in tools/gen_commands.py.
+static uint32_t commandHash(const char *name, int len, uint32_t seed)
+{
+    uint32_t h = seed;
+    for(int i = 0; i < len; ++i)
+    {
+        h = (h ^ (uint8_t)name[i]) * FNV_PRIME;
+    }
+    return h ^ (h >> 16);
+}
+
+// Run the command that exactly matches the first len bytes of buffer.
+// The perfect hash gives the only slot it can be in, so this costs two
+// hashes and one compare however many commands are registered.
+// Returns 0 if a command ran and -1 if there is no such command.
+int dispatchCommand(char *buffer, int len)
+{
+    uint32_t bucket = commandHash(buffer, len, FNV_BASIS) & (COMMAND_BUCKETS - 1);
+    uint32_t slot = commandHash(buffer, len, command_displacement[bucket]) & (COMMAND_SLOTS - 1);
+    const command_t *command = &command_table[slot];
+
+    if(command->handler == 0 || command->len != len || memcmp(command->name, buffer, len) != 0)
+    {
+        return -1;
+    }
+
+    command->handler(buffer);
+    return 0;
+}
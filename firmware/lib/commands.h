@@ -0,0 +1,23 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include <stdint.h>
+
+// A diagnostics shell command. Commands are declared with COMMAND(name,
+// handler) in lib/commands.def, or in src/commands.def for commands that
+// belong to a particular firmware; the handler gets the line buffer.
+typedef void (*command_handler_t)(char *buffer);
+
+typedef struct
+{
+    const char *name;
+    int len;
+    command_handler_t handler;
+} command_t;
+
+int dispatchCommand(char *buffer, int len);
+
+#endif
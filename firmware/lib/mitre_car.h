@@ -1,6 +1,8 @@
 // Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
 // Approved for public release. Distribution unlimited 23-02181-13.
 
+void initializeShell(void);
 void printBanner(void);
 void parseCommand(char* buffer, int len);
 int prompt(char* buffer, int max_bytes);
+int pollPrompt(char* buffer, int max_bytes);
@@ -0,0 +1,49 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+#include "text.h"
+#include "usart.h"
+
+// Codes of the compressed text; tools/gen_text.py encodes with the same.
+#define TEXT_END 0x00
+#define TEXT_RUN 0x80  // the next byte repeated TEXT_RUN_MIN + (code - TEXT_RUN) times
+#define TEXT_DICT 0xC0 // dictionary entry (code - TEXT_DICT)
+#define TEXT_RUN_MIN 3
+
+// Decode a text from the table straight into the transmit ring. Characters
+// between codes are queued as one block, as are dictionary entries and runs,
+// and the transmitter is started once at the end, as write() does.
+void writeText(unsigned int id)
+{
+    const unsigned char *code = &text_data[text_offsets[id]];
+
+    while(1)
+    {
+        const unsigned char *plain = code;
+        while(*code != TEXT_END && *code < TEXT_RUN)
+        {
+            ++code;
+        }
+        if(code != plain)
+        {
+            writeBytes((const char *)plain, code - plain);
+        }
+
+        if(*code == TEXT_END)
+        {
+            writeStart();
+            break;
+        }
+        else if(*code < TEXT_DICT)
+        {
+            writeRepeat(code[1], TEXT_RUN_MIN + (code[0] - TEXT_RUN));
+            code += 2;
+        }
+        else
+        {
+            unsigned int entry = *code++ - TEXT_DICT;
+            writeBytes((const char *)&text_dict[text_dict_offsets[entry]],
+                       text_dict_offsets[entry + 1] - text_dict_offsets[entry]);
+        }
+    }
+}
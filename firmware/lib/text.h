@@ -0,0 +1,6 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+#include "text_table.h"
+
+void writeText(unsigned int id);
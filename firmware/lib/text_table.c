@@ -0,0 +1,127 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+// Generated by tools/gen_text.py from lib/text.def.
+// Do not edit; change the .def files and rebuild.
+
+#include "text_table.h"
+
+const uint16_t text_offsets[TEXT_COUNT] = {
+    0, 545, 724, 727, 752, 801, 811, 868,
+};
+
+const uint16_t text_dict_offsets[TEXT_DICT_ENTRIES + 1] = {
+    0, 2, 20, 23, 32, 54, 56, 58, 61, 63, 65, 69,
+    71, 77, 79, 81, 88, 91, 93, 95, 97, 99, 101, 103,
+    106, 109, 111, 114,
+};
+
+const unsigned char text_dict[] = {
+    0x7c, 0x20, 0x20, 0x73, 0x79, 0x73, 0x74, 0x65, 0x6d, 0x20, 0x73, 0x74,
+    0x61, 0x74, 0x75, 0x73, 0x0a, 0x20, 0x2a, 0x20, 0x28, 0x5f, 0x29, 0x20,
+    0x2d, 0x20, 0x51, 0x75, 0x65, 0x72, 0x79, 0x20, 0x65, 0x20, 0x22, 0x48,
+    0x45, 0x4c, 0x50, 0x22, 0x20, 0x66, 0x6f, 0x72, 0x20, 0x61, 0x20, 0x6c,
+    0x69, 0x73, 0x74, 0x69, 0x6e, 0x67, 0x20, 0x20, 0x5f, 0x5f, 0x29, 0x5c,
+    0x20, 0x20, 0x5c, 0x0a, 0x20, 0x28, 0x28, 0x29, 0x2f, 0x7c, 0x5f, 0x6f,
+    0x6d, 0x6d, 0x61, 0x6e, 0x64, 0x2f, 0x20, 0x29, 0x20, 0x53, 0x79, 0x73,
+    0x74, 0x65, 0x6d, 0x20, 0x20, 0x74, 0x68, 0x61, 0x74, 0x65, 0x20, 0x20,
+    0x5f, 0x5f, 0x5c, 0x28, 0x20, 0x73, 0x20, 0x20, 0x2d, 0x20, 0x69, 0x6f,
+    0x6e, 0x69, 0x6e, 0x65, 0x6e, 0x74,
+};
+
+const unsigned char text_data[] = {
+    // BANNER
+    0xbf, 0x20, 0x83, 0x20, 0x0a, 0xc5, 0xc6, 0xc5, 0xc6, 0x20, 0x82, 0x5f,
+    0x20, 0x84, 0x5f, 0x20, 0x82, 0x5f, 0xc5, 0x83, 0x5f, 0x81, 0x20, 0x82,
+    0x5f, 0x87, 0x20, 0x82, 0x5f, 0x89, 0x20, 0xc9, 0xc0, 0xc8, 0x2f, 0xc5,
+    0xcb, 0x80, 0x20, 0x5f, 0x7c, 0xc6, 0x80, 0x20, 0xc6, 0xc0, 0x20, 0xc6,
+    0xc8, 0xc0, 0x20, 0x81, 0x5f, 0xc0, 0x20, 0xcd, 0x81, 0x5f, 0x7c, 0x80,
+    0x20, 0x2f, 0x5c, 0x80, 0x20, 0xc0, 0x20, 0xc6, 0xc8, 0x84, 0x20, 0xc9,
+    0xc0, 0x5c, 0xc5, 0xcd, 0xc0, 0xc0, 0x7c, 0x81, 0x20, 0xc0, 0xc0, 0x20,
+    0xc0, 0x7c, 0xc6, 0xce, 0xc0, 0x7c, 0xc6, 0x81, 0x20, 0xc0, 0x7c, 0x84,
+    0x20, 0x2f, 0xc5, 0x5c, 0xc5, 0xc0, 0x7c, 0xc6, 0xce, 0x7c, 0x85, 0x20,
+    0xc9, 0xc0, 0x7c, 0x5c, 0x2f, 0xc0, 0xc0, 0xc0, 0x7c, 0x81, 0x20, 0xc0,
+    0xc0, 0x20, 0xc0, 0xd3, 0xc5, 0x2f, 0xc0, 0x20, 0xc6, 0x7c, 0x80, 0x20,
+    0xc0, 0x7c, 0x83, 0x20, 0xcd, 0x2f, 0x5c, 0xc8, 0x20, 0xc0, 0xd3, 0xc5,
+    0x2f, 0x85, 0x20, 0xc9, 0xc0, 0xc0, 0x20, 0xc0, 0xcb, 0xc0, 0xcb, 0x80,
+    0x20, 0xc0, 0xc0, 0x20, 0xc0, 0xc0, 0x5c, 0xc8, 0xc0, 0x7c, 0x81, 0x5f,
+    0xc5, 0xc0, 0x7c, 0x81, 0x5f, 0x20, 0xcd, 0x81, 0x5f, 0xc8, 0xc0, 0xc0,
+    0x5c, 0xc8, 0x83, 0x20, 0xc9, 0xcb, 0xc0, 0x20, 0xcb, 0x7c, 0x82, 0x5f,
+    0xc0, 0x20, 0xcb, 0xc0, 0x20, 0xcb, 0xc0, 0xc8, 0xd4, 0x83, 0x5f, 0xc0,
+    0xc8, 0x82, 0x5f, 0x2f, 0x5f, 0x2f, 0x81, 0x20, 0x5c, 0xd4, 0x5f, 0xc0,
+    0xc8, 0xd4, 0x80, 0x20, 0x0a, 0xbf, 0x20, 0x83, 0x20, 0xc9, 0x28, 0x81,
+    0x20, 0x28, 0x93, 0x20, 0x29, 0x81, 0x20, 0x29, 0xc5, 0x28, 0x86, 0x20,
+    0x28, 0x86, 0x20, 0x28, 0x8b, 0x20, 0xc9, 0xc7, 0xce, 0xc7, 0x29, 0x80,
+    0x20, 0x28, 0x82, 0x20, 0x28, 0x83, 0x20, 0xd5, 0x2f, 0xd5, 0xd5, 0x2f,
+    0x28, 0xc5, 0xc7, 0xce, 0x2a, 0x80, 0x20, 0x29, 0xc7, 0x29, 0xc5, 0x28,
+    0x80, 0x20, 0xc7, 0x29, 0x83, 0x20, 0x0a, 0xca, 0x80, 0x28, 0x29, 0x2f,
+    0x28, 0x80, 0x20, 0x29, 0x5c, 0x81, 0x20, 0xc7, 0x29, 0x80, 0x20, 0x29,
+    0x5c, 0x28, 0x80, 0x29, 0x5c, 0x28, 0x29, 0x29, 0xca, 0x60, 0x20, 0x29,
+    0xc5, 0x2f, 0xca, 0x28, 0xc5, 0xc7, 0xca, 0x28, 0x83, 0x20, 0xc9, 0x2f,
+    0xc2, 0x29, 0x2f, 0xc2, 0x81, 0x28, 0x5f, 0x29, 0xd5, 0xca, 0x28, 0xc5,
+    0x28, 0xc2, 0x5c, 0x28, 0xc2, 0x5c, 0xc5, 0x2f, 0xc2, 0xd5, 0x29, 0xc2,
+    0x2f, 0xc2, 0x80, 0x28, 0x5f, 0xce, 0x2f, 0xc2, 0x29, 0x85, 0x20, 0x0a,
+    0xc2, 0x29, 0x5f, 0xc2, 0x29, 0xc5, 0xc7, 0x5f, 0x20, 0xc7, 0x2f, 0xc2,
+    0x29, 0x5f, 0xd3, 0x28, 0xc2, 0x20, 0x28, 0xc2, 0xc2, 0x29, 0x28, 0x5f,
+    0x28, 0x5f, 0x28, 0x29, 0xc2, 0xce, 0x29, 0x5c, 0x80, 0x5f, 0xc2, 0x29,
+    0x86, 0x20, 0xc9, 0x7c, 0x80, 0x20, 0xcb, 0xd3, 0xc0, 0xc2, 0xd4, 0x28,
+    0x5f, 0xc2, 0xce, 0xc6, 0xc0, 0x5c, 0xc0, 0x7c, 0xcd, 0x5f, 0xc8, 0xcd,
+    0xc6, 0xcb, 0x80, 0x20, 0x5f, 0xcb, 0xd3, 0x28, 0x28, 0xcd, 0xc6, 0xcd,
+    0xc6, 0x7c, 0x85, 0x20, 0xc9, 0xc0, 0x7c, 0xce, 0xc0, 0x7c, 0x80, 0x20,
+    0xcd, 0x5f, 0xc8, 0x80, 0x20, 0xc0, 0x28, 0x5f, 0x20, 0xc0, 0x2e, 0x60,
+    0x20, 0xc0, 0xc2, 0xc8, 0xc6, 0xc8, 0x20, 0xc0, 0xc0, 0x20, 0xc0, 0xc0,
+    0xc0, 0x28, 0xc6, 0x5c, 0xc6, 0xc8, 0x83, 0x20, 0xc9, 0x7c, 0x80, 0x5f,
+    0x7c, 0x80, 0x5f, 0xc0, 0x2f, 0x5f, 0x2f, 0xc8, 0xd4, 0x80, 0x20, 0x5c,
+    0x80, 0x5f, 0xcb, 0x7c, 0x5c, 0x5f, 0x7c, 0x5c, 0x80, 0x5f, 0x2f, 0x7c,
+    0x80, 0x5f, 0xcd, 0xcb, 0xc0, 0x7c, 0x80, 0x5f, 0xc0, 0x5c, 0x80, 0x5f,
+    0x7c, 0x80, 0x5f, 0x2f, 0x82, 0x20, 0x0a, 0xbf, 0x20, 0x83, 0x20, 0x0a,
+    0x54, 0x79, 0x70, 0xc4, 0x20, 0x6f, 0x66, 0x20, 0x63, 0xcc, 0x73, 0x2e,
+    0x9d, 0x20, 0x0a, 0x0a, 0x00,
+    // HELP
+    0x4d, 0x49, 0x54, 0x52, 0x45, 0x20, 0x43, 0x61, 0x72, 0x20, 0x44, 0x69,
+    0x61, 0x67, 0x6e, 0x6f, 0x74, 0x69, 0x63, 0xd6, 0xcf, 0x43, 0xcc, 0x73,
+    0x3a, 0xc9, 0x2a, 0x20, 0x48, 0x45, 0x4c, 0x50, 0xd7, 0x54, 0x68, 0x69,
+    0xd6, 0x6d, 0x65, 0x73, 0x73, 0x61, 0x67, 0x65, 0xc9, 0x2a, 0x20, 0x45,
+    0x4d, 0x49, 0x53, 0x53, 0x49, 0x4f, 0x4e, 0x53, 0xc3, 0x65, 0x6d, 0x69,
+    0x73, 0x73, 0xd8, 0x73, 0xc1, 0x53, 0x41, 0x46, 0x45, 0x54, 0x59, 0xc3,
+    0x73, 0x61, 0x66, 0x65, 0x74, 0x79, 0xc1, 0x49, 0x4e, 0x46, 0x4f, 0x54,
+    0x41, 0x49, 0x4e, 0x4d, 0x45, 0x4e, 0x54, 0xc3, 0xd9, 0x66, 0x6f, 0x72,
+    0x6d, 0xd1, 0xd8, 0x2f, 0xda, 0x65, 0x72, 0x74, 0x61, 0xd9, 0x6d, 0xda,
+    0xc1, 0x53, 0x45, 0x43, 0x55, 0x52, 0x49, 0x54, 0x59, 0xc3, 0x63, 0x79,
+    0x62, 0x65, 0x72, 0x73, 0x65, 0x63, 0x75, 0x72, 0x69, 0x74, 0x79, 0xc1,
+    0x46, 0x4c, 0x41, 0x47, 0xd7, 0x80, 0x3f, 0xc9, 0x2a, 0x20, 0x53, 0x54,
+    0x41, 0x54, 0x53, 0xd7, 0x49, 0x64, 0x6c, 0xd2, 0x43, 0x50, 0x55, 0x20,
+    0x74, 0x69, 0x6d, 0xd2, 0x61, 0x6e, 0x64, 0x20, 0x62, 0x61, 0x6e, 0x6e,
+    0x65, 0x72, 0x20, 0x74, 0x69, 0x6d, 0xd9, 0x67, 0x0a, 0x0a, 0x00,
+    // PROMPT
+    0x2d, 0x3e, 0x00,
+    // UNKNOWN_COMMAND
+    0x43, 0xcc, 0x20, 0x6e, 0x6f, 0x74, 0x20, 0x72, 0x65, 0x63, 0x6f, 0x67,
+    0x6e, 0x69, 0x7a, 0x65, 0x64, 0x2e, 0x20, 0x55, 0x73, 0xc4, 0x2e, 0x0a,
+    0x00,
+    // EMISSIONS
+    0x4e, 0x6f, 0x77, 0xd0, 0xd1, 0x20, 0x79, 0x6f, 0x75, 0x20, 0x6d, 0xda,
+    0xd8, 0x20, 0x69, 0x74, 0x2c, 0xd0, 0xd2, 0x73, 0x6d, 0x6f, 0x6b, 0xd2,
+    0x75, 0x73, 0x75, 0x61, 0x6c, 0x6c, 0x79, 0x20, 0x69, 0x73, 0x6e, 0x27,
+    0x74, 0xd0, 0xd1, 0x20, 0x63, 0x6f, 0x6c, 0x6f, 0x72, 0x80, 0x2e, 0x0a,
+    0x00,
+    // SAFETY
+    0xcf, 0x6e, 0x6f, 0x72, 0x6d, 0x61, 0x6c, 0x2e, 0x0a, 0x00,
+    // INFOTAINMENT
+    0x50, 0x6c, 0x61, 0x79, 0xd9, 0x67, 0x20, 0x76, 0x69, 0x64, 0x65, 0x6f,
+    0x3a, 0x20, 0x68, 0x74, 0x74, 0x70, 0x73, 0x3a, 0x2f, 0x2f, 0x80, 0x77,
+    0x2e, 0x79, 0x6f, 0x75, 0x74, 0x75, 0x62, 0x65, 0x2e, 0x63, 0x6f, 0x6d,
+    0x2f, 0x77, 0xd1, 0x63, 0x68, 0x3f, 0x76, 0x3d, 0x64, 0x51, 0x77, 0x34,
+    0x77, 0x39, 0x57, 0x67, 0x58, 0x63, 0x51, 0x0a, 0x00,
+    // SECURITY
+    0x4e, 0x6f, 0x20, 0x76, 0x69, 0x72, 0x75, 0x73, 0x65, 0xd6, 0x64, 0x65,
+    0x74, 0x65, 0x63, 0x74, 0x65, 0x64, 0x2e, 0x20, 0x53, 0x69, 0x67, 0x6e,
+    0xd1, 0x75, 0x72, 0x65, 0xd6, 0x6c, 0x61, 0x73, 0x74, 0x20, 0x75, 0x70,
+    0x64, 0xd1, 0x65, 0x64, 0x20, 0x31, 0x2f, 0x31, 0x2f, 0x31, 0x39, 0x37,
+    0x30, 0x2e, 0x0a, 0x46, 0x69, 0x72, 0x65, 0x77, 0x61, 0x6c, 0x6c, 0x20,
+    0x64, 0x69, 0x73, 0x61, 0x62, 0x6c, 0x65, 0x64, 0x20, 0x62, 0x65, 0x63,
+    0x61, 0x75, 0x73, 0xd2, 0x69, 0x74, 0x20, 0x73, 0x74, 0x6f, 0x70, 0x73,
+    0xd0, 0xd2, 0x61, 0x69, 0x72, 0x62, 0x61, 0x67, 0xd6, 0x66, 0x72, 0x6f,
+    0x6d, 0x20, 0x64, 0x65, 0x70, 0x6c, 0x6f, 0x79, 0xd9, 0x67, 0x2e, 0x0a,
+    0x00,
+};
@@ -0,0 +1,33 @@
+// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+// Approved for public release. Distribution unlimited 23-02181-13.
+
+// Generated by tools/gen_text.py from lib/text.def.
+// Do not edit; change the .def files and rebuild.
+
+#ifndef TEXT_TABLE_H
+#define TEXT_TABLE_H
+
+#include <stdint.h>
+
+#define TEXT_COUNT 8
+#define TEXT_DICT_ENTRIES 27
+
+#define TEXT_BANNER 0
+#define TEXT_HELP 1
+#define TEXT_PROMPT 2
+#define TEXT_UNKNOWN_COMMAND 3
+#define TEXT_EMISSIONS 4
+#define TEXT_SAFETY 5
+#define TEXT_INFOTAINMENT 6
+#define TEXT_SECURITY 7
+
+// 1893 bytes of text stored in 1163
+#define TEXT_PLAIN_SIZE 1893
+#define TEXT_TABLE_SIZE 1163
+
+extern const uint16_t text_offsets[TEXT_COUNT];
+extern const uint16_t text_dict_offsets[TEXT_DICT_ENTRIES + 1];
+extern const unsigned char text_dict[];
+extern const unsigned char text_data[];
+
+#endif
@@ -4,43 +4,252 @@
 #include "usart.h"
 #include "uart.h"
 
-int readLine(char *buffer, int max_bytes)
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "inc/hw_ints.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/uart.h"
+
+// Line discipline states
+#define LINE_EDIT 0     // collecting characters
+#define LINE_AFTER_CR 1 // line just ended with '\r'; a '\n' here is part of it
+#define LINE_DISCARD 2  // line too long; dropping the rest of it
+
+// Receive and transmit rings. The interrupt handler is the only writer of
+// rx_head and tx_tail, the main loop the only writer of rx_tail and tx_head.
+static volatile unsigned char rx_buffer[USART_RX_BUFFER_SIZE];
+static volatile unsigned int rx_head;
+static volatile unsigned int rx_tail;
+static volatile unsigned char tx_buffer[USART_TX_BUFFER_SIZE];
+static volatile unsigned int tx_head;
+static volatile unsigned int tx_tail;
+
+static int line_state;
+static int line_len;
+
+// Move queued bytes into the hardware FIFO until either runs out. Called from
+// the interrupt handler, and from the main loop with the interrupt masked.
+static void fillTxFifo(void)
 {
-    int i;
-    int ret;
-    for (i = 0;i < max_bytes; ++i)
+    while(tx_tail != tx_head && UARTSpaceAvail(UART2_BASE))
     {
-        // Fetch the received byte value into the variable "received_byte".
-        char received_byte = uart_read(UART2, 1, &ret);
-        // If the line has ended, terminate the string and break. Otherwise,
-        // store the byte and contintue.
-        if(received_byte == '\n' || received_byte == '\r')
+        UARTCharPutNonBlocking(UART2_BASE, tx_buffer[tx_tail]);
+        tx_tail = (tx_tail + 1) & (USART_TX_BUFFER_SIZE - 1);
+    }
+}
+
+// The transmit interrupt only fires as the FIFO drains, so an idle UART has
+// to be primed from the main loop.
+static void kickTx(void)
+{
+    IntDisable(INT_UART2);
+    fillTxFifo();
+    IntEnable(INT_UART2);
+}
+
+// UART2's entry in the firmware's vector table (src/startup_gcc.c).
+void UART2_IRQHandler(void)
+{
+    unsigned long status = UARTIntStatus(UART2_BASE, true);
+    UARTIntClear(UART2_BASE, status);
+
+    // Bytes that arrive with the ring full are dropped.
+    while(UARTCharsAvail(UART2_BASE))
+    {
+        unsigned char c = UARTCharGetNonBlocking(UART2_BASE);
+        unsigned int next = (rx_head + 1) & (USART_RX_BUFFER_SIZE - 1);
+        if(next != rx_tail)
         {
-            buffer[i] = '\0';
-            break;
+            rx_buffer[rx_head] = c;
+            rx_head = next;
+        }
+    }
+
+    fillTxFifo();
+}
+
+// Feed whatever has been received through the line discipline: '\r', '\n'
+// or "\r\n" end a line, backspace and delete remove the last character, and
+// anything beyond max_bytes - 1 characters is dropped. Characters collect in
+// buffer, so pass the same buffer until a line is returned.
+// Returns the length of the completed, NUL terminated line, or -1 if the
+// line is not complete yet.
+int pollLine(char *buffer, int max_bytes)
+{
+    while(rx_tail != rx_head)
+    {
+        char c = rx_buffer[rx_tail];
+        rx_tail = (rx_tail + 1) & (USART_RX_BUFFER_SIZE - 1);
+
+        if(line_state == LINE_AFTER_CR)
+        {
+            line_state = LINE_EDIT;
+            if(c == '\n')
+            {
+                continue;
+            }
+        }
+
+        if(c == '\r' || c == '\n')
+        {
+            int len = line_len;
+            buffer[len] = '\0';
+            line_len = 0;
+            line_state = (c == '\r') ? LINE_AFTER_CR : LINE_EDIT;
+            return len;
+        }
+        else if(line_state == LINE_DISCARD)
+        {
+            continue;
+        }
+        else if(c == '\b' || c == 0x7F)
+        {
+            if(line_len > 0)
+            {
+                line_len--;
+            }
+        }
+        else if(line_len == max_bytes - 1)
+        {
+            line_state = LINE_DISCARD;
         }
         else
         {
-            buffer[i] = received_byte;
+            buffer[line_len++] = c;
         }
     }
 
-    // Reture number of bytes received (length of string).
-    return i;
+    return -1;
+}
+
+// Wait for a complete line.
+int readLine(char *buffer, int max_bytes)
+{
+    int len;
+    while((len = pollLine(buffer, max_bytes)) < 0)
+    {
+    }
+    return len;
 }
 
+// Append one byte to the transmit ring, waiting only while it is full.
+static inline void queueTx(char c)
+{
+    unsigned int next = (tx_head + 1) & (USART_TX_BUFFER_SIZE - 1);
+    while(next == tx_tail)
+    {
+        kickTx();
+    }
+    tx_buffer[tx_head] = c;
+    tx_head = next;
+}
+
+// Queue a string for transmission. Only waits if the transmit ring is full.
 void write(const char *buffer)
 {
-    uart_write_str(UART2, (char *) buffer); // Send the byte.
+    for(; *buffer != '\0'; ++buffer)
+    {
+        queueTx(*buffer);
+    }
+    kickTx();
+}
+
+// Free space in the transmit ring, waiting (and draining it) while there is
+// none. One byte always stays empty to tell a full ring from an empty one.
+static unsigned int txSpace(void)
+{
+    unsigned int space;
+    while((space = (tx_tail - tx_head - 1) & (USART_TX_BUFFER_SIZE - 1)) == 0)
+    {
+        kickTx();
+    }
+    return space;
+}
+
+// Queue len bytes, which need not be NUL terminated, without starting the
+// transmitter; follow a series of these with writeStart(). Copies as much as
+// fits at a time and publishes it with a single update of the head.
+void writeBytes(const char *buffer, unsigned int len)
+{
+    while(len > 0)
+    {
+        unsigned int n = txSpace();
+        unsigned int head = tx_head;
+        if(n > len)
+        {
+            n = len;
+        }
+        len -= n;
+        while(n-- > 0)
+        {
+            tx_buffer[head] = *buffer++;
+            head = (head + 1) & (USART_TX_BUFFER_SIZE - 1);
+        }
+        tx_head = head;
+    }
+}
+
+// Queue count copies of c, like writeBytes().
+void writeRepeat(char c, unsigned int count)
+{
+    while(count > 0)
+    {
+        unsigned int n = txSpace();
+        unsigned int head = tx_head;
+        if(n > count)
+        {
+            n = count;
+        }
+        count -= n;
+        while(n-- > 0)
+        {
+            tx_buffer[head] = c;
+            head = (head + 1) & (USART_TX_BUFFER_SIZE - 1);
+        }
+        tx_head = head;
+    }
+}
+
+// Start transmitting whatever has been queued.
+void writeStart(void)
+{
+    kickTx();
 }
 
 void writeLine(const char *buffer)
 {
     write(buffer);
-    nl(UART2);
+    write("\n");
+}
+
+void writeNumber(unsigned long value)
+{
+    char digits[11];
+    int i = sizeof(digits) - 1;
+
+    digits[i] = '\0';
+    do
+    {
+        digits[--i] = '0' + value % 10;
+        value /= 10;
+    } while(value != 0);
+
+    write(&digits[i]);
+}
+
+// True once everything written has left the UART.
+int writeIdle(void)
+{
+    return tx_tail == tx_head && !UARTBusy(UART2_BASE);
 }
 
 void initializeUSART()
 {
     uart_init(UART2);
+
+    // The rings and line state live in .bss, which ResetISR() clears, so
+    // they start out empty.
+    UARTFIFOLevelSet(UART2_BASE, UART_FIFO_TX4_8, UART_FIFO_RX4_8);
+    UARTIntEnable(UART2_BASE, UART_INT_RX | UART_INT_RT | UART_INT_TX);
+    IntEnable(INT_UART2);
 }
@@ -4,7 +4,18 @@
 #define USART_BAUDRATE 115200
 #define BAUD_PRESCALE (((F_CPU / (USART_BAUDRATE * 16UL))) - 1)
 
+// Interrupt-fed receive and transmit rings; sizes must be powers of two.
+// The transmit ring holds the whole startup banner.
+#define USART_RX_BUFFER_SIZE 256
+#define USART_TX_BUFFER_SIZE 2048
+
 int readLine(char* buffer, int max_bytes);
+int pollLine(char* buffer, int max_bytes);
 void write(const char *buffer);
+void writeBytes(const char *buffer, unsigned int len);
+void writeRepeat(char c, unsigned int count);
+void writeStart(void);
 void writeLine(const char* buffer);
+void writeNumber(unsigned long value);
+int writeIdle(void);
 void initializeUSART(void);
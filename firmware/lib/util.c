@@ -2,42 +2,227 @@
 // Approved for public release. Distribution unlimited 23-02181-13.
 
 #include "util.h"
+#include <stdint.h>
 #include <string.h>
 
+// Host builds (tools/bench_hex.py) get vector paths; the Cortex-M3 and
+// -DHEX_NO_SIMD builds use the word-at-a-time loops alone.
+#if !defined(HEX_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if !defined(HEX_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 // strnlen seems to be nonstandard in this setup, but it is present so signature to supress warning
 size_t strnlen(const char *s, size_t maxlen);
 
-char hex2nybble(char nybble)
+/*
+ * hex_pairs[b] is the two digits of byte b, high nybble in the low byte, so
+ * a little-endian store writes them in order. hex_values[c] is 0x10 | value
+ * for a hex digit and 0 for anything else: ANDing entries together leaves
+ * 0x10 set only if every character was valid, which lets the loops check
+ * once at the end rather than branch per character.
+ */
+#define HEX_DIGIT(n) ((n) < 10 ? '0' + (n) : 'a' - 10 + (n))
+#define HEX_PAIR(b) (HEX_DIGIT((b) >> 4) | HEX_DIGIT((b) & 0xF) << 8)
+#define HEX_PAIRS4(b) HEX_PAIR(b), HEX_PAIR((b) + 1), HEX_PAIR((b) + 2), HEX_PAIR((b) + 3)
+#define HEX_PAIRS16(b) HEX_PAIRS4(b), HEX_PAIRS4((b) + 4), HEX_PAIRS4((b) + 8), HEX_PAIRS4((b) + 12)
+#define HEX_PAIRS64(b) HEX_PAIRS16(b), HEX_PAIRS16((b) + 16), HEX_PAIRS16((b) + 32), HEX_PAIRS16((b) + 48)
+
+static const uint16_t hex_pairs[256] = {
+    HEX_PAIRS64(0), HEX_PAIRS64(64), HEX_PAIRS64(128), HEX_PAIRS64(192)
+};
+
+#define HEX_VALID 0x10
+
+static const uint8_t hex_values[256] = {
+    ['0'] = HEX_VALID | 0x0, ['1'] = HEX_VALID | 0x1, ['2'] = HEX_VALID | 0x2,
+    ['3'] = HEX_VALID | 0x3, ['4'] = HEX_VALID | 0x4, ['5'] = HEX_VALID | 0x5,
+    ['6'] = HEX_VALID | 0x6, ['7'] = HEX_VALID | 0x7, ['8'] = HEX_VALID | 0x8,
+    ['9'] = HEX_VALID | 0x9,
+    ['A'] = HEX_VALID | 0xA, ['B'] = HEX_VALID | 0xB, ['C'] = HEX_VALID | 0xC,
+    ['D'] = HEX_VALID | 0xD, ['E'] = HEX_VALID | 0xE, ['F'] = HEX_VALID | 0xF,
+    ['a'] = HEX_VALID | 0xA, ['b'] = HEX_VALID | 0xB, ['c'] = HEX_VALID | 0xC,
+    ['d'] = HEX_VALID | 0xD, ['e'] = HEX_VALID | 0xE, ['f'] = HEX_VALID | 0xF,
+};
+
+int hex2nybble(char nybble)
+{
+    uint8_t value = hex_values[(uint8_t)nybble];
+    return (value & HEX_VALID) ? value & 0xF : -1;
+}
+
+int hex2byte(char upper_nybble, char lower_nybble)
+{
+    uint8_t upper = hex_values[(uint8_t)upper_nybble];
+    uint8_t lower = hex_values[(uint8_t)lower_nybble];
+    if(!(upper & lower & HEX_VALID)) return -1;
+    return (upper & 0xF) << 4 | (lower & 0xF);
+}
+
+// Four hex characters, as loaded little-endian, to two bytes.
+static inline uint32_t decodeWord(uint32_t word, uint32_t *valid)
+{
+    uint32_t n0 = hex_values[word & 0xFF];
+    uint32_t n1 = hex_values[(word >> 8) & 0xFF];
+    uint32_t n2 = hex_values[(word >> 16) & 0xFF];
+    uint32_t n3 = hex_values[word >> 24];
+    *valid &= n0 & n1 & n2 & n3;
+    return (n0 & 0xF) << 4 | (n1 & 0xF) | (n2 & 0xF) << 12 | (n3 & 0xF) << 8;
+}
+
+#if !defined(HEX_NO_SIMD) && defined(__AVX2__)
+// 32 hex characters to their nybble values; lanes that are not hex digits
+// clear their byte of *valid.
+static inline __m256i nybblesAVX2(__m256i c, __m256i *valid)
+{
+    __m256i d = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+    __m256i l = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    __m256i is_digit = _mm256_and_si256(_mm256_cmpgt_epi8(d, _mm256_set1_epi8(-1)),
+                                        _mm256_cmpgt_epi8(_mm256_set1_epi8(10), d));
+    __m256i is_letter = _mm256_and_si256(_mm256_cmpgt_epi8(l, _mm256_set1_epi8(-1)),
+                                         _mm256_cmpgt_epi8(_mm256_set1_epi8(6), l));
+    *valid = _mm256_and_si256(*valid, _mm256_or_si256(is_digit, is_letter));
+    return _mm256_or_si256(_mm256_and_si256(is_digit, d),
+                           _mm256_and_si256(is_letter, _mm256_add_epi8(l, _mm256_set1_epi8(10))));
+}
+
+// Nybble pairs to bytes in the low byte of each 16-bit lane.
+static inline __m256i pairsAVX2(__m256i n)
+{
+    return _mm256_and_si256(_mm256_or_si256(_mm256_slli_epi16(n, 4), _mm256_srli_epi16(n, 8)),
+                            _mm256_set1_epi16(0xFF));
+}
+
+static inline __m256i digitsAVX2(__m256i n)
+{
+    __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(n, _mm256_set1_epi8(9)), _mm256_set1_epi8('a' - '0' - 10));
+    return _mm256_add_epi8(n, _mm256_add_epi8(letter, _mm256_set1_epi8('0')));
+}
+#endif
+
+#if !defined(HEX_NO_SIMD) && defined(__SSE2__)
+static inline __m128i nybblesSSE2(__m128i c, __m128i *valid)
+{
+    __m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i l = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(d, _mm_set1_epi8(-1)), _mm_cmplt_epi8(d, _mm_set1_epi8(10)));
+    __m128i is_letter = _mm_and_si128(_mm_cmpgt_epi8(l, _mm_set1_epi8(-1)), _mm_cmplt_epi8(l, _mm_set1_epi8(6)));
+    *valid = _mm_and_si128(*valid, _mm_or_si128(is_digit, is_letter));
+    return _mm_or_si128(_mm_and_si128(is_digit, d), _mm_and_si128(is_letter, _mm_add_epi8(l, _mm_set1_epi8(10))));
+}
+
+static inline __m128i pairsSSE2(__m128i n)
 {
-    if(nybble >= 'A' && nybble <= 'F') return nybble - 'A' + 10;
-    else if(nybble >= 'a' && nybble <= 'f') return nybble - 'a' + 10;
-    else if(nybble >= '0' && nybble <= '9') return nybble - '0';
-    else return -1;
+    return _mm_and_si128(_mm_or_si128(_mm_slli_epi16(n, 4), _mm_srli_epi16(n, 8)), _mm_set1_epi16(0xFF));
 }
 
-char hex2byte(char upper_nybble, char lower_nybble)
+static inline __m128i digitsSSE2(__m128i n)
 {
-    return (hex2nybble(upper_nybble) << 4) | hex2nybble(lower_nybble);
+    __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(n, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10));
+    return _mm_add_epi8(n, _mm_add_epi8(letter, _mm_set1_epi8('0')));
 }
+#endif
 
 int hex2str(char *hex_str, int length, char *byte_str)
 {
     length = strnlen(hex_str, length);
-    int i;
-    for(i = 0; i < length; i+=2)
+    if(length & 1) return -1;
+
+    int i = 0;
+    uint32_t valid = HEX_VALID;
+
+#if !defined(HEX_NO_SIMD) && defined(__AVX2__)
+    __m256i valid256 = _mm256_set1_epi8(-1);
+    for(; i + 64 <= length; i += 64)
+    {
+        __m256i n0 = nybblesAVX2(_mm256_loadu_si256((const __m256i *)(hex_str + i)), &valid256);
+        __m256i n1 = nybblesAVX2(_mm256_loadu_si256((const __m256i *)(hex_str + i + 32)), &valid256);
+        // packus works within 128-bit lanes; put the quarters back in order.
+        __m256i bytes = _mm256_packus_epi16(pairsAVX2(n0), pairsAVX2(n1));
+        _mm256_storeu_si256((__m256i *)(byte_str + (i >> 1)), _mm256_permute4x64_epi64(bytes, 0xD8));
+    }
+    if(_mm256_movemask_epi8(valid256) != -1) valid = 0;
+#endif
+
+#if !defined(HEX_NO_SIMD) && defined(__SSE2__)
+    __m128i valid128 = _mm_set1_epi8(-1);
+    for(; i + 32 <= length; i += 32)
+    {
+        __m128i n0 = nybblesSSE2(_mm_loadu_si128((const __m128i *)(hex_str + i)), &valid128);
+        __m128i n1 = nybblesSSE2(_mm_loadu_si128((const __m128i *)(hex_str + i + 16)), &valid128);
+        _mm_storeu_si128((__m128i *)(byte_str + (i >> 1)), _mm_packus_epi16(pairsSSE2(n0), pairsSSE2(n1)));
+    }
+    if(_mm_movemask_epi8(valid128) != 0xFFFF) valid = 0;
+#endif
+
+    // Eight characters to four bytes per pass. memcpy keeps the unaligned
+    // accesses legal C; on the Cortex-M3 each one is a single LDR or STR.
+    for(; i + 8 <= length; i += 8)
+    {
+        uint32_t lo, hi;
+        memcpy(&lo, hex_str + i, 4);
+        memcpy(&hi, hex_str + i + 4, 4);
+        uint32_t bytes = decodeWord(lo, &valid) | decodeWord(hi, &valid) << 16;
+        memcpy(byte_str + (i >> 1), &bytes, 4);
+    }
+
+    for(; i < length; i += 2)
     {
-        byte_str[i>>1] = hex2byte(hex_str[i], hex_str[i+1]);
+        uint8_t upper = hex_values[(uint8_t)hex_str[i]];
+        uint8_t lower = hex_values[(uint8_t)hex_str[i+1]];
+        valid &= upper & lower;
+        byte_str[i>>1] = (upper & 0xF) << 4 | (lower & 0xF);
     }
-    return i>>1;
+
+    return valid ? i>>1 : -1;
 }
 
 int str2hex(char *byte_str, int length, char *hex_str)
 {
-    int i;
-    for(i = 0; i < length; ++i)
+    int i = 0;
+
+#if !defined(HEX_NO_SIMD) && defined(__AVX2__)
+    for(; i + 32 <= length; i += 32)
+    {
+        __m256i bytes = _mm256_loadu_si256((const __m256i *)(byte_str + i));
+        __m256i hi = digitsAVX2(_mm256_and_si256(_mm256_srli_epi16(bytes, 4), _mm256_set1_epi8(0xF)));
+        __m256i lo = digitsAVX2(_mm256_and_si256(bytes, _mm256_set1_epi8(0xF)));
+        // unpack works within 128-bit lanes; put the quarters back in order.
+        __m256i first = _mm256_unpacklo_epi8(hi, lo);
+        __m256i second = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256((__m256i *)(hex_str + i * 2), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256((__m256i *)(hex_str + i * 2 + 32), _mm256_permute2x128_si256(first, second, 0x31));
+    }
+#endif
+
+#if !defined(HEX_NO_SIMD) && defined(__SSE2__)
+    for(; i + 16 <= length; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)(byte_str + i));
+        __m128i hi = digitsSSE2(_mm_and_si128(_mm_srli_epi16(bytes, 4), _mm_set1_epi8(0xF)));
+        __m128i lo = digitsSSE2(_mm_and_si128(bytes, _mm_set1_epi8(0xF)));
+        _mm_storeu_si128((__m128i *)(hex_str + i * 2), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *)(hex_str + i * 2 + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+#endif
+
+    // Four bytes to eight characters per pass.
+    for(; i + 4 <= length; i += 4)
+    {
+        uint32_t bytes;
+        memcpy(&bytes, byte_str + i, 4);
+        uint32_t lo = hex_pairs[bytes & 0xFF] | (uint32_t)hex_pairs[(bytes >> 8) & 0xFF] << 16;
+        uint32_t hi = hex_pairs[(bytes >> 16) & 0xFF] | (uint32_t)hex_pairs[bytes >> 24] << 16;
+        memcpy(hex_str + i * 2, &lo, 4);
+        memcpy(hex_str + i * 2 + 4, &hi, 4);
+    }
+
+    for(; i < length; ++i)
     {
-        hex_str[i*2]   = (byte_str[i]>>4)  > 9 ? (byte_str[i]>>4)  + 'a' - 10 : (byte_str[i]>>4)  + '0';
-        hex_str[i*2+1] = (byte_str[i]&0xF) > 9 ? (byte_str[i]&0xF) + 'a' - 10 : (byte_str[i]&0xF) + '0';
+        uint16_t pair = hex_pairs[(uint8_t)byte_str[i]];
+        memcpy(hex_str + i * 2, &pair, 2);
     }
     return i*2;
 }
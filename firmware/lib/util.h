@@ -1,7 +1,11 @@
 // Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
 // Approved for public release. Distribution unlimited 23-02181-13.
 
-char hex2nybble(char nybble);
-char hex2byte(char upper_nybble, char lower_nybble);
+// Hex codec. Decoding is validated: hex2nybble() and hex2byte() return -1
+// for a character that is not a hex digit, and hex2str() returns -1 if any
+// character is invalid or the hex string has an odd length (byte_str is
+// then unspecified). Encoding writes lower-case digits and no terminator.
+int hex2nybble(char nybble);
+int hex2byte(char upper_nybble, char lower_nybble);
 int hex2str(char* hex_str, int length, char* byte_str);
 int str2hex(char *byte_str, int length, char *hex_str);
@@ -1,33 +1,122 @@
 // Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
 // Approved for public release. Distribution unlimited 23-02181-13.
 
+#include <stdint.h>
 #include <string.h>
 
+#include "driverlib/sysctl.h"
+#include "driverlib/systick.h"
+
 #define VERSION_2
 #include "usart.h"
 #include "uart.h"
 #include "util.h"
 #include "mitre_car.h"
 
+// SysTick is a 24-bit down counter; it is used free running as a cycle clock.
+#define CYCLE_COUNTER_MASK 0xFFFFFF
+
+// Time allowed from the boot command to the first prompt being on the wire.
+#define BOOT_TO_PROMPT_BUDGET_US 200000
+
+// Boot timing from the bootloader, set up by ResetISR() in startup_gcc.c.
+extern unsigned long g_ulResetCycles;
+extern unsigned long g_ulBootCycles;
+extern unsigned long g_ulEntryTick;
+
 static const char *FLAG_RESPONSE = "Nice try.";
 
+// Main loop statistics, reported by the STATS command. Times are in cycles.
+static uint64_t idle_cycles;
+static uint64_t total_cycles;
+static uint32_t banner_queued; // until printBanner() returned
+static uint32_t banner_sent;   // until the last banner byte left the UART
+static uint32_t prompt_cycles; // from entering the firmware to the same point
+
 void getFlag(char *flag)
 {
     flag = strcpy(flag, FLAG_RESPONSE);
 }
 
-int main(void) __attribute__((section(".text.main")));
+// Registered in src/commands.def
+void flagCommand(char *buffer)
+{
+    getFlag(buffer);
+    writeLine(buffer);
+}
+
+static uint32_t cyclesToMicros(uint64_t cycles)
+{
+    return (uint32_t)(cycles / (SysCtlClockGet() / 1000000));
+}
+
+// Registered in src/commands.def. Reports the share of main loop time that
+// was spent waiting for input since the last report.
+void statsCommand(char *buffer)
+{
+    write("Idle CPU: ");
+    writeNumber(total_cycles ? (uint32_t)(idle_cycles * 100 / total_cycles) : 0);
+    writeLine("%");
+    write("Banner queued in ");
+    writeNumber(cyclesToMicros(banner_queued));
+    write(" us, sent in ");
+    writeNumber(cyclesToMicros(banner_sent));
+    writeLine(" us");
+
+    uint32_t boot_us = cyclesToMicros((uint64_t)g_ulBootCycles + prompt_cycles);
+    write("Reset to prompt: ");
+    writeNumber(cyclesToMicros((uint64_t)g_ulResetCycles + prompt_cycles));
+    writeLine(" us");
+    write("Boot command to prompt: ");
+    writeNumber(boot_us);
+    write(" us");
+    writeLine(boot_us > BOOT_TO_PROMPT_BUDGET_US ? " (over budget)" : "");
+
+    idle_cycles = 0;
+    total_cycles = 0;
+}
+
+static uint32_t cyclesSince(uint32_t start)
+{
+    return (start - SysTickValueGet()) & CYCLE_COUNTER_MASK;
+}
+
 int main (void)
 {
+    char buff[256];
+    int banner_pending = 1;
+
+    initializeShell();
+
+    SysTickPeriodSet(CYCLE_COUNTER_MASK + 1);
+    SysTickEnable();
+    idle_cycles = 0;
+    total_cycles = 0;
+    banner_sent = 0;
+
+    uint32_t banner_start = SysTickValueGet();
     printBanner();
+    banner_queued = cyclesSince(banner_start);
+
     for(;;) // Loop forever.
     {
-        char buff[256];
-        int len = prompt(buff, 256);
-        if(buff[0] != '\0' && strncmp(buff, "FLAG", len) == 0)
+        // Each pass must stay under one SysTick wrap (about 1.4 s at 12 MHz).
+        uint32_t start = SysTickValueGet();
+        int ran_command = pollPrompt(buff, 256) >= 0;
+
+        // Background work goes here; for now, time the banner on the wire.
+        if(banner_pending && writeIdle())
+        {
+            banner_sent = cyclesSince(banner_start);
+            prompt_cycles = cyclesSince(g_ulEntryTick);
+            banner_pending = 0;
+        }
+
+        uint32_t elapsed = cyclesSince(start);
+        total_cycles += elapsed;
+        if(!ran_command)
         {
-            getFlag(buff);
-            writeLine(buff);
+            idle_cycles += elapsed;
         }
     }
 }
@@ -0,0 +1,350 @@
+//*****************************************************************************
+//
+// startup_gcc.c - Startup code for use with GNU tools.
+//
+// Copyright (c) 2013 Texas Instruments Incorporated.  All rights reserved.
+// Software License Agreement
+// 
+//   Redistribution and use in source and binary forms, with or without
+//   modification, are permitted provided that the following conditions
+//   are met:
+// 
+//   Redistributions of source code must retain the above copyright
+//   notice, this list of conditions and the following disclaimer.
+// 
+//   Redistributions in binary form must reproduce the above copyright
+//   notice, this list of conditions and the following disclaimer in the
+//   documentation and/or other materials provided with the  
+//   distribution.
+// 
+//   Neither the name of Texas Instruments Incorporated nor the names of
+//   its contributors may be used to endorse or promote products derived
+//   from this software without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// 
+// This is part of revision 10636 of the Stellaris Firmware Development Package.
+//
+//*****************************************************************************
+
+#include "inc/hw_types.h"
+#include "inc/hw_nvic.h"
+#include "driverlib/interrupt.h"
+
+//*****************************************************************************
+//
+// The bootloader starts the firmware through this vector table at the start
+// of its slot: it points VTOR here, loads the stack pointer from the first
+// entry and calls ResetISR() with the cycles it took from reset, and from the
+// boot command, to the hand-off.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Forward declaration of the default fault handlers.
+//
+//*****************************************************************************
+void ResetISR(unsigned long ulResetCycles, unsigned long ulBootCycles);
+static void NmiSR(void);
+static void FaultISR(void);
+static void IntDefaultHandler(void);
+
+
+
+
+//*****************************************************************************
+//
+// USER ADD TO ME
+//
+// Forward declarations of interrupt handlers.
+//
+//******************************************************************************
+extern void UART0_IRQHandler(void);
+extern void UART2_IRQHandler(void);
+
+
+
+
+//*****************************************************************************
+//
+// The entry point for the application.
+//
+//*****************************************************************************
+extern int main(void);
+
+//*****************************************************************************
+//
+// The system stack is reserved by the linker script, past the end of .bss.
+//
+//*****************************************************************************
+extern unsigned long _estack;
+
+//*****************************************************************************
+//
+// The vector table.  Note that the proper constructs must be placed on this to
+// ensure that it ends up at physical address 0x0000.0000.
+//
+//*****************************************************************************
+__attribute__ ((section(".isr_vector")))
+void (* const g_pfnVectors[])(void) =
+{
+    (void (*)(void))((unsigned long)&_estack),
+                                            // The initial stack pointer
+    (void (*)(void))ResetISR,               // The reset handler
+    NmiSR,                                  // The NMI handler
+    FaultISR,                               // The hard fault handler
+    IntDefaultHandler,                      // The MPU fault handler
+    IntDefaultHandler,                      // The bus fault handler
+    IntDefaultHandler,                      // The usage fault handler
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    IntDefaultHandler,                      // SVCall handler
+    IntDefaultHandler,                      // Debug monitor handler
+    0,                                      // Reserved
+    IntDefaultHandler,                      // The PendSV handler
+    IntDefaultHandler,                      // The SysTick handler
+    IntDefaultHandler,                      // GPIO Port A
+    IntDefaultHandler,                      // GPIO Port B
+    IntDefaultHandler,                      // GPIO Port C
+    IntDefaultHandler,                      // GPIO Port D
+    IntDefaultHandler,                      // GPIO Port E
+    UART0_IRQHandler,                      // UART0 Rx and Tx
+    IntDefaultHandler,                      // UART1 Rx and Tx
+    IntDefaultHandler,                      // SSI0 Rx and Tx
+    IntDefaultHandler,                      // I2C0 Master and Slave
+    IntDefaultHandler,                      // PWM Fault
+    IntDefaultHandler,                      // PWM Generator 0
+    IntDefaultHandler,                      // PWM Generator 1
+    IntDefaultHandler,                      // PWM Generator 2
+    IntDefaultHandler,                      // Quadrature Encoder 0
+    IntDefaultHandler,                      // ADC Sequence 0
+    IntDefaultHandler,                      // ADC Sequence 1
+    IntDefaultHandler,                      // ADC Sequence 2
+    IntDefaultHandler,                      // ADC Sequence 3
+    IntDefaultHandler,                      // Watchdog timer
+    IntDefaultHandler,                      // Timer 0 subtimer A
+    IntDefaultHandler,                      // Timer 0 subtimer B
+    IntDefaultHandler,                      // Timer 1 subtimer A
+    IntDefaultHandler,                      // Timer 1 subtimer B
+    IntDefaultHandler,                      // Timer 2 subtimer A
+    IntDefaultHandler,                      // Timer 2 subtimer B
+    IntDefaultHandler,                      // Analog Comparator 0
+    IntDefaultHandler,                      // Analog Comparator 1
+    IntDefaultHandler,                      // Analog Comparator 2
+    IntDefaultHandler,                      // System Control (PLL, OSC, BO)
+    IntDefaultHandler,                      // FLASH Control
+    IntDefaultHandler,                      // GPIO Port F
+    IntDefaultHandler,                      // GPIO Port G
+    IntDefaultHandler,                      // GPIO Port H
+    UART2_IRQHandler,                      // UART2 Rx and Tx
+    IntDefaultHandler,                      // SSI1 Rx and Tx
+    IntDefaultHandler,                      // Timer 3 subtimer A
+    IntDefaultHandler,                      // Timer 3 subtimer B
+    IntDefaultHandler,                      // I2C1 Master and Slave
+    IntDefaultHandler,                      // Quadrature Encoder 1
+    IntDefaultHandler,                      // CAN0
+    IntDefaultHandler,                      // CAN1
+    IntDefaultHandler,                      // CAN2
+    IntDefaultHandler,                      // Ethernet
+    IntDefaultHandler,                      // Hibernate
+    IntDefaultHandler,                      // USB0
+    IntDefaultHandler,                      // PWM Generator 3
+    IntDefaultHandler,                      // uDMA Software Transfer
+    IntDefaultHandler,                      // uDMA Error
+    IntDefaultHandler,                      // ADC1 Sequence 0
+    IntDefaultHandler,                      // ADC1 Sequence 1
+    IntDefaultHandler,                      // ADC1 Sequence 2
+    IntDefaultHandler,                      // ADC1 Sequence 3
+    IntDefaultHandler,                      // I2S0
+    IntDefaultHandler,                      // External Bus Interface 0
+    IntDefaultHandler                       // GPIO Port J
+};
+
+//*****************************************************************************
+//
+// The following are constructs created by the linker, indicating where the
+// the "data" and "bss" segments reside in memory.  The initializers for the
+// "data" segment are loaded in flash at _ldata.
+//
+//*****************************************************************************
+extern unsigned long _ldata;
+extern unsigned long _data;
+extern unsigned long _edata;
+extern unsigned long _bss;
+extern unsigned long _ebss;
+
+//*****************************************************************************
+//
+// Copy words from pulSrc to pulDest until pulDest reaches pulEnd, eight at a
+// time with LDM/STM and then one at a time. Inlined, since the bss zero fill
+// may clear the stack a call would return through.
+//
+//*****************************************************************************
+static inline __attribute__((always_inline)) void
+CopyWords(unsigned long *pulDest, unsigned long *pulSrc, unsigned long *pulEnd)
+{
+    unsigned long ulLeft;
+
+    __asm volatile("1:  sub     %2, %3, %0\n"
+                   "    cmp     %2, #32\n"
+                   "    blt     2f\n"
+                   "    ldmia   %1!, {r3-r6, r8-r10, r12}\n"
+                   "    stmia   %0!, {r3-r6, r8-r10, r12}\n"
+                   "    b       1b\n"
+                   "2:  cmp     %0, %3\n"
+                   "    ittt    lt\n"
+                   "    ldrlt   r3, [%1], #4\n"
+                   "    strlt   r3, [%0], #4\n"
+                   "    blt     2b\n"
+                   : "+r" (pulDest), "+r" (pulSrc), "=&r" (ulLeft)
+                   : "r" (pulEnd)
+                   : "r3", "r4", "r5", "r6", "r8", "r9", "r10", "r12", "cc",
+                     "memory");
+}
+
+//*****************************************************************************
+//
+// Zero words from pulDest until pulEnd, eight at a time with STM and then one
+// at a time.
+//
+//*****************************************************************************
+static inline __attribute__((always_inline)) void
+ZeroWords(unsigned long *pulDest, unsigned long *pulEnd)
+{
+    unsigned long ulLeft;
+
+    __asm volatile("    movs    r3, #0\n"
+                   "    mov     r4, r3\n"
+                   "    mov     r5, r3\n"
+                   "    mov     r6, r3\n"
+                   "    mov     r8, r3\n"
+                   "    mov     r9, r3\n"
+                   "    mov     r10, r3\n"
+                   "    mov     r12, r3\n"
+                   "1:  sub     %1, %2, %0\n"
+                   "    cmp     %1, #32\n"
+                   "    blt     2f\n"
+                   "    stmia   %0!, {r3-r6, r8-r10, r12}\n"
+                   "    b       1b\n"
+                   "2:  cmp     %0, %2\n"
+                   "    itt     lt\n"
+                   "    strlt   r3, [%0], #4\n"
+                   "    blt     2b\n"
+                   : "+r" (pulDest), "=&r" (ulLeft)
+                   : "r" (pulEnd)
+                   : "r3", "r4", "r5", "r6", "r8", "r9", "r10", "r12", "cc",
+                     "memory");
+}
+
+//*****************************************************************************
+//
+// Boot timing handed over by the bootloader, in cycles, and the SysTick value
+// on entry. The bootloader leaves SysTick counting down from 2^24 - 1, so
+// main() can keep timing from here with the same counter.
+//
+//*****************************************************************************
+unsigned long g_ulResetCycles;
+unsigned long g_ulBootCycles;
+unsigned long g_ulEntryTick;
+
+//*****************************************************************************
+//
+// This is the code that gets called when the bootloader hands off to the
+// firmware. The stack is already set up, outside .bss; the data segment is
+// initialized, bss cleared and interrupts, masked for the hand-off, enabled
+// again before the application's entry point is called.
+//
+//*****************************************************************************
+void
+ResetISR(unsigned long ulResetCycles, unsigned long ulBootCycles)
+{
+    unsigned long ulEntryTick = HWREG(NVIC_ST_CURRENT);
+
+    //
+    // Copy the data segment initializers from flash to SRAM.
+    //
+    CopyWords(&_data, &_ldata, &_edata);
+
+    //
+    // Zero fill the bss segment.
+    //
+    ZeroWords(&_bss, &_ebss);
+
+    g_ulResetCycles = ulResetCycles;
+    g_ulBootCycles = ulBootCycles;
+    g_ulEntryTick = ulEntryTick;
+
+    IntMasterEnable();
+
+    //
+    // Call the application's entry point.
+    //
+    main();
+}
+
+//*****************************************************************************
+//
+// This is the code that gets called when the processor receives a NMI.  This
+// simply enters an infinite loop, preserving the system state for examination
+// by a debugger.
+//
+//*****************************************************************************
+static void
+NmiSR(void)
+{
+    //
+    // Enter an infinite loop.
+    //
+    while(1)
+    {
+    }
+}
+
+//*****************************************************************************
+//
+// This is the code that gets called when the processor receives a fault
+// interrupt.  This simply enters an infinite loop, preserving the system state
+// for examination by a debugger.
+//
+//*****************************************************************************
+static void
+FaultISR(void)
+{
+    //
+    // Enter an infinite loop.
+    //
+    while(1)
+    {
+    }
+}
+
+//*****************************************************************************
+//
+// This is the code that gets called when the processor receives an unexpected
+// interrupt.  This simply enters an infinite loop, preserving the system state
+// for examination by a debugger.
+//
+//*****************************************************************************
+static void
+IntDefaultHandler(void)
+{
+    //
+    // Go into an infinite loop.
+    //
+    while(1)
+    {
+    }
+}
\ No newline at end of file
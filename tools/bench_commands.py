@@ -0,0 +1,136 @@
+#!/usr/bin/env python
+
+# Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+# Approved for public release. Distribution unlimited 23-02181-13.
+
+"""
+Diagnostics Shell Dispatch Benchmark
+
+Builds the firmware's command dispatcher (firmware/lib/commands.c) natively
+for synthetic command sets of several sizes and times it against the strncmp
+chain it replaced. Needs a host C compiler:
+
+    python bench_commands.py --sizes 10 100 1000
+"""
+import argparse
+import os
+import pathlib
+import random
+import shutil
+import string
+import subprocess
+import tempfile
+
+import gen_commands
+
+REPO_ROOT = pathlib.Path(__file__).parent.parent.absolute()
+FIRMWARE_LIB = os.path.join(REPO_ROOT, "firmware/lib")
+
+BENCH_MAIN = r"""
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "commands.h"
+#include "names.h"
+
+volatile unsigned long hits;
+#define HANDLER(n) void handler##n(char *buffer) { hits++; }
+#include "handlers.h"
+
+// The dispatch it replaces: try each command in turn with the old
+// strncmp(buffer, name, len) test.
+static int chainDispatch(char *buffer, int len)
+{
+    for(int i = 0; i < NAME_COUNT; ++i)
+    {
+        if(strncmp(buffer, names[i], len) == 0)
+        {
+            hits++;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static double nsPerCall(int (*dispatch)(char *, int))
+{
+    char buffer[64];
+    struct timespec start, end;
+    long calls = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int r = 0; r < ROUNDS; ++r)
+    {
+        for(int i = 0; i < QUERY_COUNT; ++i)
+        {
+            int len = strlen(queries[i]);
+            memcpy(buffer, queries[i], len + 1);
+            dispatch(buffer, len);
+            calls++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / calls;
+}
+
+int main(void)
+{
+    printf("%.1f %.1f\n", nsPerCall(chainDispatch), nsPerCall(dispatchCommand));
+    return 0;
+}
+"""
+
+
+def random_names(count, rng):
+    names = set()
+    while len(names) < count:
+        names.add("".join(rng.choice(string.ascii_uppercase) for _ in range(rng.randint(4, 12))))
+    return sorted(names)
+
+
+def bench(size, rounds, cc, rng):
+    names = random_names(size, rng)
+    # Every command once, plus as many misses.
+    queries = names + [name + "X" for name in names]
+    rng.shuffle(queries)
+
+    with tempfile.TemporaryDirectory() as tmp:
+        def_path = os.path.join(tmp, "commands.def")
+        with open(def_path, "w") as fp:
+            fp.writelines(f'COMMAND("{name}", handler{i})\n' for i, name in enumerate(names))
+        gen_commands.write_header(os.path.join(tmp, "command_table.h"), gen_commands.read_commands([def_path]), [def_path])
+
+        # commands.c includes command_table.h from its own directory, so it
+        # is built from a copy next to the generated table.
+        shutil.copy(os.path.join(FIRMWARE_LIB, "commands.c"), tmp)
+        shutil.copy(os.path.join(FIRMWARE_LIB, "commands.h"), tmp)
+
+        with open(os.path.join(tmp, "handlers.h"), "w") as fp:
+            fp.writelines(f"HANDLER({i})\n" for i in range(size))
+        with open(os.path.join(tmp, "names.h"), "w") as fp:
+            fp.write(f"#define NAME_COUNT {size}\n#define QUERY_COUNT {len(queries)}\n#define ROUNDS {rounds}\n")
+            fp.write("static const char *names[] = {" + ", ".join(f'"{n}"' for n in names) + "};\n")
+            fp.write("static const char *queries[] = {" + ", ".join(f'"{q}"' for q in queries) + "};\n")
+        with open(os.path.join(tmp, "bench.c"), "w") as fp:
+            fp.write(BENCH_MAIN)
+
+        binary = os.path.join(tmp, "bench")
+        subprocess.check_call([cc, "-O2", "-std=gnu99", "-I", tmp, "-o", binary,
+                               os.path.join(tmp, "bench.c"), os.path.join(tmp, "commands.c")])
+        chain, table = subprocess.check_output([binary], text=True).split()
+        return float(chain), float(table)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Diagnostics Shell Dispatch Benchmark")
+    parser.add_argument("--sizes", help="Command set sizes to time.", type=int, nargs="+", default=[10, 100, 1000])
+    parser.add_argument("--rounds", help="Passes over the query set per measurement.", type=int, default=2000)
+    parser.add_argument("--cc", help="Host C compiler.", default="cc")
+    parser.add_argument("--seed", help="Seed for the synthetic command names.", type=int, default=1)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    print(f"{'commands':>8}  {'strncmp chain':>14}  {'perfect hash':>13}")
+    for size in args.sizes:
+        chain, table = bench(size, max(1, args.rounds * 10 // size), args.cc, rng)
+        print(f"{size:>8}  {chain:>11.1f} ns  {table:>10.1f} ns")
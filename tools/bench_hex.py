@@ -0,0 +1,187 @@
+#!/usr/bin/env python
+
+# Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+# Approved for public release. Distribution unlimited 23-02181-13.
+
+"""
+Hex Codec Benchmark
+
+Builds the firmware's hex codec (firmware/lib/util.c) natively and times
+str2hex()/hex2str() against the nybble-at-a-time versions they replaced, in
+bytes (of binary data) per cycle. The codec is built three ways: the
+word-at-a-time loops the Cortex-M3 runs (-DHEX_NO_SIMD), and the SSE2 and
+AVX2 paths when the compiler and CPU have them. Needs a host C compiler:
+
+    python bench_hex.py --sizes 64 1024 16384
+
+Cycles come from the time-stamp counter on x86 and are estimated from
+--ghz elsewhere.
+"""
+import argparse
+import os
+import pathlib
+import platform
+import subprocess
+import tempfile
+
+REPO_ROOT = pathlib.Path(__file__).parent.parent.absolute()
+FIRMWARE_LIB = os.path.join(REPO_ROOT, "firmware/lib")
+
+BENCH_MAIN = r"""
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "util.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// The codec util.c replaced, for reference.
+static char oldHex2nybble(char nybble)
+{
+    if(nybble >= 'A' && nybble <= 'F') return nybble - 'A' + 10;
+    else if(nybble >= 'a' && nybble <= 'f') return nybble - 'a' + 10;
+    else if(nybble >= '0' && nybble <= '9') return nybble - '0';
+    else return -1;
+}
+
+static int oldHex2str(char *hex_str, int length, char *byte_str)
+{
+    length = strnlen(hex_str, length);
+    int i;
+    for(i = 0; i < length; i+=2)
+    {
+        byte_str[i>>1] = (oldHex2nybble(hex_str[i]) << 4) | oldHex2nybble(hex_str[i+1]);
+    }
+    return i>>1;
+}
+
+static int oldStr2hex(char *byte_str, int length, char *hex_str)
+{
+    int i;
+    for(i = 0; i < length; ++i)
+    {
+        hex_str[i*2]   = (byte_str[i]>>4)  > 9 ? (byte_str[i]>>4)  + 'a' - 10 : (byte_str[i]>>4)  + '0';
+        hex_str[i*2+1] = (byte_str[i]&0xF) > 9 ? (byte_str[i]&0xF) + 'a' - 10 : (byte_str[i]&0xF) + '0';
+    }
+    return i*2;
+}
+
+static uint64_t now(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)((ts.tv_sec * 1e9 + ts.tv_nsec) * GHZ);
+#endif
+}
+
+typedef int (*codec_t)(char *in, int length, char *out);
+
+static double bytesPerCycle(codec_t codec, char *in, int length, char *out, int bytes)
+{
+    uint64_t best = UINT64_MAX;
+    for(int trial = 0; trial < 5; ++trial)
+    {
+        uint64_t start = now();
+        for(int r = 0; r < ROUNDS; ++r)
+        {
+            codec(in, length, out);
+            __asm__ volatile("" : : "r"(out) : "memory");
+        }
+        uint64_t cycles = now() - start;
+        if(cycles < best) best = cycles;
+    }
+    return (double)bytes * ROUNDS / best;
+}
+
+int main(void)
+{
+    static char bytes[SIZE], hex[SIZE * 2 + 1], check[SIZE];
+    srand(1);
+    for(int i = 0; i < SIZE; ++i) bytes[i] = rand();
+
+    // The new codec must agree with the old one on valid input (the old
+    // str2hex sign-extends bytes >= 0x80, so compare against a fixed copy),
+    // round-trip, and reject a bad character anywhere.
+    if(str2hex(bytes, SIZE, hex) != SIZE * 2) return 1;
+    hex[SIZE * 2] = 0;
+    for(int i = 0; i < SIZE; ++i)
+    {
+        if(hex[i*2] != "0123456789abcdef"[(uint8_t)bytes[i] >> 4]) return 2;
+        if(hex[i*2+1] != "0123456789abcdef"[bytes[i] & 0xF]) return 2;
+    }
+    if(hex2str(hex, SIZE * 2, check) != SIZE || memcmp(check, bytes, SIZE)) return 3;
+    oldHex2str(hex, SIZE * 2, check);
+    if(memcmp(check, bytes, SIZE)) return 3;
+    for(int i = 0; i < SIZE * 2; i += SIZE / 4 + 1)
+    {
+        char saved = hex[i];
+        hex[i] = 'g';
+        if(hex2str(hex, SIZE * 2, check) != -1) return 4;
+        hex[i] = saved;
+    }
+
+    printf("%.4f %.4f %.4f %.4f\n",
+           bytesPerCycle(oldStr2hex, bytes, SIZE, hex, SIZE),
+           bytesPerCycle(str2hex, bytes, SIZE, hex, SIZE),
+           bytesPerCycle(oldHex2str, hex, SIZE * 2, check, SIZE),
+           bytesPerCycle(hex2str, hex, SIZE * 2, check, SIZE));
+    return 0;
+}
+"""
+
+# Codec builds: name, extra compiler flags, whether the CPU must report a flag.
+VARIANTS = [
+    ("word", ["-DHEX_NO_SIMD"], None),
+    ("sse2", ["-msse2"], "sse2"),
+    ("avx2", ["-mavx2"], "avx2"),
+]
+
+
+def cpu_has(flag):
+    if flag is None:
+        return True
+    if platform.machine() not in ("x86_64", "AMD64", "i386", "i686"):
+        return False
+    try:
+        with open("/proc/cpuinfo") as fp:
+            return any(flag in line.split() for line in fp if line.startswith("flags"))
+    except OSError:
+        return flag == "sse2"
+
+
+def bench(size, rounds, cc, flags, ghz):
+    with tempfile.TemporaryDirectory() as tmp:
+        with open(os.path.join(tmp, "bench.c"), "w") as fp:
+            fp.write(BENCH_MAIN)
+
+        binary = os.path.join(tmp, "bench")
+        subprocess.check_call([cc, "-O2", "-std=gnu99", *flags, f"-DSIZE={size}", f"-DROUNDS={rounds}",
+                               f"-DGHZ={ghz}", "-I", FIRMWARE_LIB, "-o", binary,
+                               os.path.join(tmp, "bench.c"), os.path.join(FIRMWARE_LIB, "util.c")])
+        result = subprocess.run([binary], capture_output=True, text=True)
+        if result.returncode:
+            raise RuntimeError(f"Codec self-check failed ({result.returncode}) with {' '.join(flags)}")
+        return [float(v) for v in result.stdout.split()]
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Hex Codec Benchmark")
+    parser.add_argument("--sizes", help="Binary buffer sizes to time.", type=int, nargs="+", default=[64, 1024, 16384])
+    parser.add_argument("--bytes", help="Bytes to process per measurement.", type=int, default=1 << 24)
+    parser.add_argument("--cc", help="Host C compiler.", default="cc")
+    parser.add_argument("--ghz", help="Clock for converting time to cycles off x86.", type=float, default=1.0)
+    args = parser.parse_args()
+
+    variants = [(name, flags) for name, flags, cpu_flag in VARIANTS if cpu_has(cpu_flag)]
+    print("bytes/cycle, binary bytes per cycle")
+    print(f"{'size':>6}  {'codec':>5}  {'old encode':>10}  {'encode':>7}  {'old decode':>10}  {'decode':>7}")
+    for size in args.sizes:
+        for name, flags in variants:
+            old_enc, enc, old_dec, dec = bench(size, max(1, args.bytes // size), args.cc, flags, args.ghz)
+            print(f"{size:>6}  {name:>5}  {old_enc:>10.3f}  {enc:>7.3f}  {old_dec:>10.3f}  {dec:>7.3f}")
@@ -0,0 +1,266 @@
+#!/usr/bin/env python
+
+# Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+# Approved for public release. Distribution unlimited 23-02181-13.
+
+"""
+Update Throughput Benchmark
+
+Pushes synthetic firmware images through the bootloader over the real socket
+path and measures each update end to end. Images range from 1 KB to a full
+slot, with random or compressible content, sent plain or compressed
+(fw_protect.py --compress). For every case the emulator is started fresh with
+bl_emulate.py, the image is sent with fw_update.py's protocol 2 code, and the
+firmware is booted:
+
+    python bench_update.py --sizes 1 16 full --json results.json
+
+Reported per case: image bytes per second of update time, the round trip of
+each frame from being written to being acknowledged (percentiles), and the
+time from starting the update until the bootloader has printed the release
+message on its way into the firmware. --json writes the results with the
+commit they were taken at, for tracking protocol changes over time.
+
+With --attach the bootloader already listening on the sockets is used
+instead, and is reset through UART0 between cases.
+"""
+import argparse
+import contextlib
+import datetime
+import io
+import json
+import os
+import pathlib
+import random
+import socket
+import subprocess
+import tempfile
+import threading
+import time
+
+import bl_emulate
+import fw_protect
+import fw_update
+from util import *
+
+REPO_ROOT = pathlib.Path(__file__).parent.parent.absolute()
+
+SLOT_SIZE = 0x10000
+VERSION = 0  # always accepted, so cases can follow each other
+MESSAGE = "bench {size} {content}"
+RESET = b"\x20"  # written to UART0
+
+CONNECT_TIMEOUT = 10.0
+BOOT_TIMEOUT = 10.0
+
+
+def synthetic_firmware(size, content, rng):
+    # Random bytes do not compress at all; the compressible image is drawn
+    # from a small vocabulary of 4-byte words, roughly like Thumb code.
+    if content == "random":
+        return rng.randbytes(size)
+    words = [rng.randbytes(4) for _ in range(64)]
+    return b"".join(rng.choice(words) for _ in range(size // 4 + 1))[:size]
+
+
+def make_images(directory, size, content, message, compress, rng):
+    # Blobs for both slots; only the flag differs since nothing is executed.
+    firmware = synthetic_firmware(size, content, rng)
+    infile = os.path.join(directory, f"fw-{size}-{content}.bin")
+    with open(infile, "wb") as fp:
+        fp.write(firmware)
+
+    blobs = []
+    for slot in "ab":
+        outfile = os.path.join(directory, f"fw-{size}-{content}-{int(compress)}-{slot}.blob")
+        with contextlib.redirect_stdout(io.StringIO()):
+            fw_protect.protect_firmware(infile, outfile, VERSION, message, compress=compress, slot=slot, digest="crc32")
+        blobs.append(outfile)
+    with open(blobs[0], "rb") as fp:
+        wire_size = len(fw_update.parse_blob(fp.read())[3])
+    return blobs, wire_size
+
+
+def connect(path):
+    deadline = time.monotonic() + CONNECT_TIMEOUT
+    while True:
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            sock.connect(path)
+            return sock
+        except OSError:
+            sock.close()
+            if time.monotonic() > deadline:
+                raise
+            time.sleep(0.1)
+
+
+class Console:
+    # Collects everything the device prints on UART2 in the background, so
+    # the emulator never stalls on a full socket.
+    def __init__(self, sock):
+        self.sock = sock
+        self.data = b""
+        self.changed = threading.Condition()
+        threading.Thread(target=self._read, daemon=True).start()
+
+    def _read(self):
+        while True:
+            try:
+                chunk = self.sock.recv(4096)
+            except OSError:
+                chunk = b""
+            with self.changed:
+                if not chunk:
+                    self.sock = None
+                    self.changed.notify_all()
+                    return
+                self.data += chunk
+                self.changed.notify_all()
+
+    def wait_for(self, text, start, timeout):
+        # Wait until text shows up after offset start; returns True if it did.
+        deadline = time.monotonic() + timeout
+        with self.changed:
+            while text not in self.data[start:]:
+                remaining = deadline - time.monotonic()
+                if remaining <= 0 or self.sock is None:
+                    return False
+                self.changed.wait(remaining)
+        return True
+
+
+def open_device():
+    # Same connection order as fw_update.py: QEMU opens each socket in turn.
+    uart0 = connect(UART0_PATH)
+    time.sleep(0.2)
+    uart1 = connect(UART1_PATH)
+    time.sleep(0.2)
+    uart2 = connect(UART2_PATH)
+    return uart0, uart1, Console(uart2)
+
+
+def percentile(values, pct):
+    # Nearest-rank percentile of a sorted list.
+    if not values:
+        return None
+    rank = max(1, -(-len(values) * pct // 100))
+    return values[int(rank) - 1]
+
+
+def run_case(uart1, console, blobs, message, window, frame_size):
+    ser = DomainSocketSerial(uart1)
+    frame_times = []
+
+    start = time.perf_counter()
+    with contextlib.redirect_stdout(io.StringIO()):
+        fw_update.update(ser, blobs[0], False, window=window, frame_size=frame_size, infile_b=blobs[1], frame_times=frame_times)
+    updated = time.perf_counter()
+
+    console_start = len(console.data)
+    ser.write(b"B")
+    while ser.read(1) != b"B":
+        pass
+    booted = console.wait_for(message.encode(), console_start, BOOT_TIMEOUT)
+    end = time.perf_counter()
+
+    frame_times.sort()
+    return {
+        "update_s": updated - start,
+        "boot_s": (end - updated) if booted else None,
+        "total_s": (end - start) if booted else None,
+        "frames": len(frame_times),
+        "frame_rtt_ms": {
+            name: round(percentile(frame_times, pct) * 1e3, 3) if frame_times else None
+            for name, pct in (("p50", 50), ("p90", 90), ("p99", 99), ("max", 100))
+        },
+    }
+
+
+def git_revision():
+    try:
+        return subprocess.check_output(["git", "rev-parse", "HEAD"], cwd=REPO_ROOT, text=True, stderr=subprocess.DEVNULL).strip()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+
+def parse_size(text):
+    # Sizes in KB, or "full" for the largest image a slot holds.
+    if text == "full":
+        return None
+    return int(text) * 1024
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Update Throughput Benchmark")
+    parser.add_argument("--sizes", help="Image sizes in KB, or 'full' for a whole slot.", nargs="+", default=["1", "4", "16", "full"])
+    parser.add_argument("--content", help="Image content to try.", nargs="+", choices=["random", "compressible"], default=["random", "compressible"])
+    parser.add_argument("--compress", help="Send images plain, compressed or both.", choices=["no", "yes", "both"], default="both")
+    parser.add_argument("--window", help="Frames in flight.", type=int, default=fw_update.V2_WINDOW)
+    parser.add_argument("--frame-size", help="Frame data size.", type=int, default=fw_update.V2_FRAME_SIZE)
+    parser.add_argument("--boot-path", help="Bootloader binary for the emulator.", default=os.path.join(REPO_ROOT, "bootloader/gcc/main.axf"))
+    parser.add_argument("--attach", help="Use the bootloader already listening on the sockets.", action="store_true")
+    parser.add_argument("--seed", help="Seed for the synthetic images.", type=int, default=1)
+    parser.add_argument("--json", help="Write the results to this file as JSON.", default=None)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    compress_modes = {"no": [False], "yes": [True], "both": [False, True]}[args.compress]
+    results = []
+
+    print(f"{'size':>6}  {'content':>12}  {'lz':>3}  {'wire':>6}  {'KB/s':>8}  {'rtt p50':>8}  {'rtt p99':>8}  {'to boot':>8}")
+    with tempfile.TemporaryDirectory() as tmp:
+        for size_text in args.sizes:
+            size = parse_size(size_text)
+            for content in args.content:
+                message = MESSAGE.format(size=size_text, content=content)
+                # The firmware, message and its terminator share the slot.
+                image_size = size if size is not None else SLOT_SIZE - len(message) - 1
+                for compress in compress_modes:
+                    blobs, wire_size = make_images(tmp, image_size, content, message, compress, rng)
+
+                    if args.attach:
+                        uart0, uart1, console = open_device()
+                    else:
+                        bl_emulate.emulate(pathlib.Path(args.boot_path).resolve())
+                        uart0, uart1, console = open_device()
+
+                    try:
+                        result = run_case(uart1, console, blobs, message, args.window, args.frame_size)
+                    finally:
+                        if args.attach:
+                            with contextlib.suppress(OSError):
+                                uart0.send(RESET)
+                            time.sleep(0.5)
+                        for sock in (uart0, uart1, console.sock):
+                            if sock is not None:
+                                sock.close()
+
+                    total = image_size + len(message) + 1
+                    result.update({
+                        "size": total,
+                        "content": content,
+                        "compressed": compress,
+                        "wire_bytes": wire_size,
+                        "bytes_per_s": round(total / result["update_s"]),
+                    })
+                    results.append(result)
+
+                    boot = f"{result['total_s']:.2f} s" if result["total_s"] is not None else "-"
+                    print(f"{total:>6}  {content:>12}  {'yes' if compress else 'no':>3}  {wire_size:>6}  "
+                          f"{result['bytes_per_s'] / 1024:>8.1f}  {result['frame_rtt_ms']['p50']:>5.1f} ms  "
+                          f"{result['frame_rtt_ms']['p99']:>5.1f} ms  {boot:>8}")
+
+    if not args.attach:
+        os.system("pkill qemu")
+
+    if args.json:
+        with open(args.json, "w") as fp:
+            json.dump({
+                "benchmark": "update_throughput",
+                "date": datetime.datetime.now(datetime.timezone.utc).isoformat(timespec="seconds"),
+                "revision": git_revision(),
+                "window": args.window,
+                "frame_size": args.frame_size,
+                "results": results,
+            }, fp, indent=2)
@@ -10,16 +10,27 @@ import os
 from util import *
 
 
-def emulate(binary_path, debug=False):
+def emulate(binary_path, debug=False, socket_dir=None):
+    # Start QEMU with its UARTs on domain sockets. By default this is the one
+    # emulator on /embsec and anything left over is cleaned up first. With
+    # socket_dir the sockets go there instead and other running emulators are
+    # left alone, so several can run side by side (see fw_fleet.py).
     cmd = ["qemu-system-arm", "-M", "lm3s6965evb", "-nographic", "-kernel", binary_path]
 
     if debug:
         cmd.extend(["-s", "-S"])
 
-    uart_paths = ["/embsec/UART0", "/embsec/UART1", "/embsec/UART2"]
+    paths = uart_paths(socket_dir)
     for i in range(3):
-        cmd.extend(["-serial", f"unix:{uart_paths[i]},server"])
-    
+        cmd.extend(["-serial", f"unix:{paths[i]},server"])
+
+    if socket_dir is not None:
+        os.makedirs(socket_dir, exist_ok=True)
+        for path in paths:
+            if os.path.exists(path):
+                os.remove(path)
+        return subprocess.Popen(cmd)
+
     # Try to kill and delete leftover stuff before starting qemu
     os.system("pkill qemu")
     try:
@@ -38,17 +49,18 @@ def emulate(binary_path, debug=False):
         pass
     os.system("rm -rf /flash/*")
     
-    subprocess.Popen(cmd)
+    return subprocess.Popen(cmd)
 
 
 if __name__ == "__main__":
     parser = argparse.ArgumentParser(description="Stellaris Emulator")
     parser.add_argument("--boot-path", help="Path to the the bootloader binary.", default=None)
     parser.add_argument("--debug", help="Start GDB server and break on first instruction", action="store_true")
+    parser.add_argument("--socket-dir", help="Put the UART sockets here and leave other emulators running.", default=None)
     args = parser.parse_args()
     if args.boot_path is None:
         binary_path = (pathlib.Path(__file__).parent / ".." / "bootloader" / "gcc" / "main.axf")
     else:
         binary_path = pathlib.Path(args.boot_path)
 
-    emulate(binary_path.resolve(), debug=args.debug)
+    emulate(binary_path.resolve(), debug=args.debug, socket_dir=args.socket_dir)
@@ -0,0 +1,229 @@
+#!/usr/bin/env python
+
+# Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+# Approved for public release. Distribution unlimited 23-02181-13.
+
+"""
+Fleet Updater Tool
+
+Pushes one firmware image to many emulated devices at once. Every device is
+an emulator with its own socket directory (bl_emulate.py --socket-dir), and
+all of them are driven from a single asyncio event loop with the protocol 2
+windowed update of fw_update.py, so the fleet takes as long as its slowest
+device rather than the sum of all of them.
+
+Launch eight emulators under /tmp/fleet/0 .. /tmp/fleet/7 and update them:
+
+    python fw_fleet.py --firmware a.blob --firmware-b b.blob --launch 8
+
+or update emulators that are already running:
+
+    python fw_fleet.py --firmware a.blob --firmware-b b.blob --attach /tmp/fleet/0 /tmp/fleet/1
+
+Progress is printed per device as it goes. A device that fails or stops
+answering is reported and retried (--retries) on its own; the others carry
+on. The exit status is the number of devices that could not be updated.
+"""
+
+import argparse
+import asyncio
+import os
+import pathlib
+import struct
+import time
+
+import bl_emulate
+import fw_update
+from util import *
+
+CONNECT_TIMEOUT = 10.0
+PROGRESS_STEP = 25  # percent between progress lines
+FLUSH_QUIET = 0.1
+
+
+class Device:
+    def __init__(self, name, socket_dir):
+        self.name = name
+        self.socket_dir = socket_dir
+        self.reader = None
+        self.writer = None
+        self.sent = 0
+        self.size = 0
+        self.reported = -1
+        self.elapsed = None
+        self.error = None
+
+    def log(self, message):
+        print(f"[{self.name}] {message}", flush=True)
+
+    def progress(self, sent):
+        self.sent = sent
+        percent = 100 * sent // self.size if self.size else 100
+        if percent // PROGRESS_STEP > self.reported:
+            self.reported = percent // PROGRESS_STEP
+            self.log(f"{percent}% ({sent} of {self.size} bytes)")
+
+    async def read(self, size, timeout):
+        return await asyncio.wait_for(self.reader.readexactly(size), timeout)
+
+    async def expect(self, byte, timeout):
+        # Skip anything before the echo of a command byte.
+        while await self.read(1, timeout) != byte:
+            pass
+
+    async def write(self, data):
+        self.writer.write(data)
+        await self.writer.drain()
+
+    async def flush_input(self):
+        # Throw away whatever arrives until the line goes quiet, e.g. the
+        # banner after the bootloader reset.
+        try:
+            while await asyncio.wait_for(self.reader.read(4096), FLUSH_QUIET):
+                pass
+        except asyncio.TimeoutError:
+            pass
+
+
+async def connect(path):
+    deadline = time.monotonic() + CONNECT_TIMEOUT
+    while True:
+        try:
+            return await asyncio.open_unix_connection(path)
+        except OSError:
+            if time.monotonic() > deadline:
+                raise
+            await asyncio.sleep(0.1)
+
+
+async def open_device(device):
+    # Same order as fw_update.py: QEMU opens each socket once the previous one
+    # is connected. Only UART1 is used; the others are closed so the emulator
+    # does not block on them.
+    paths = uart_paths(device.socket_dir)
+    _, uart0 = await connect(paths[0])
+    device.reader, device.writer = await connect(paths[1])
+    _, uart2 = await connect(paths[2])
+    uart0.close()
+    uart2.close()
+
+
+async def send_metadata_v2(device, images, timeout):
+    await device.write(b"V")
+    await device.expect(b"V", timeout)
+
+    proto, max_window, max_frame, slot = fw_update.V2_CAPS.unpack(await device.read(fw_update.V2_CAPS.size, timeout))
+    if slot not in images:
+        raise RuntimeError(f"No image linked for slot {fw_update.SLOT_NAMES[slot]} (see --firmware-b)")
+    image = images[slot]
+
+    await device.write(fw_update.v2_metadata(image))
+    resp = await device.read(1, timeout)
+    if resp != fw_update.RESP_OK:
+        raise RuntimeError("Bootloader responded with {}".format(repr(resp)))
+    (resume,) = struct.unpack("<I", await device.read(4, timeout))
+
+    return image, max_window, max_frame, resume
+
+
+async def update_v2(device, images, window, frame_size, timeout):
+    # fw_update.update_v2() on the event loop: fw_update.V2Transfer plans the
+    # frames and follows the window, this only sends and reads.
+    image, max_window, max_frame, resume = await send_metadata_v2(device, images, timeout)
+    transfer = fw_update.V2Transfer(image, window, frame_size, max_window, max_frame, resume, log=device.log)
+    if resume:
+        device.log(f"resuming at byte {resume}")
+
+    device.size = image["size"]
+    while not transfer.done():
+        frames = transfer.pending()
+        stored = transfer.stored_span(frames)
+        if stored is not None:
+            offset, length = stored
+            device.writer.write(transfer.framed.view[offset : offset + length])
+        else:
+            for idx in frames:
+                header, data = transfer.frame(idx)
+                device.writer.write(header + data)
+        transfer.sent(frames)
+        await device.writer.drain()
+
+        transfer.ack(fw_update.check_ack(await device.read(2, timeout)))
+        device.progress(transfer.acked_bytes())
+
+
+async def update_device(device, images, args):
+    start = time.perf_counter()
+    try:
+        await open_device(device)
+        for attempt in range(args.retries + 1):
+            try:
+                await update_v2(device, images, args.window, args.frame_size, args.timeout)
+                break
+            except (RuntimeError, OSError, asyncio.IncompleteReadError, asyncio.TimeoutError) as e:
+                if attempt == args.retries:
+                    raise
+                device.log(f"update interrupted ({e or type(e).__name__}), retrying")
+                await asyncio.sleep(fw_update.RETRY_DELAY)
+                await device.flush_input()
+
+        if args.boot:
+            await device.write(b"B")
+            await device.expect(b"B", args.timeout)
+        device.elapsed = time.perf_counter() - start
+        device.log(f"done in {device.elapsed:.2f} s")
+    except Exception as e:
+        device.error = str(e) or type(e).__name__
+        device.log(f"FAILED: {device.error}")
+    finally:
+        if device.writer is not None:
+            device.writer.close()
+
+
+async def update_fleet(devices, images, args):
+    # One task per device; a failure is recorded on its device and never
+    # cancels the others.
+    await asyncio.gather(*(update_device(device, images, args) for device in devices))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Fleet Updater Tool")
+    parser.add_argument("--firmware", help="Path to firmware image to load.", required=True)
+    parser.add_argument("--firmware-b", help="The same firmware linked for slot B (fw_protect.py --slot b).", default=None)
+    devices_group = parser.add_mutually_exclusive_group(required=True)
+    devices_group.add_argument("--launch", help="Start this many emulators and update them.", type=int, default=None)
+    devices_group.add_argument("--attach", help="Socket directories of emulators that are already running.", nargs="+", default=None)
+    parser.add_argument("--socket-root", help="Where --launch puts each emulator's socket directory.", default="/tmp/fleet")
+    parser.add_argument("--boot-path", help="Bootloader binary for --launch.", default=os.path.join(pathlib.Path(__file__).parent, "..", "bootloader", "gcc", "main.axf"))
+    parser.add_argument("--window", help="Frames in flight per device.", type=int, default=fw_update.V2_WINDOW)
+    parser.add_argument("--frame-size", help="Frame data size.", type=int, default=fw_update.V2_FRAME_SIZE)
+    parser.add_argument("--retries", help="Resume an interrupted update this many times per device.", type=int, default=0)
+    parser.add_argument("--timeout", help="Seconds to wait for a device before giving up on it.", type=float, default=10.0)
+    parser.add_argument("--boot", help="Boot the new firmware on each device after its update.", action="store_true")
+    args = parser.parse_args()
+
+    images = fw_update.load_images([args.firmware] + ([args.firmware_b] if args.firmware_b else []), [None, None])
+
+    processes = []
+    if args.launch is not None:
+        socket_dirs = [os.path.join(args.socket_root, str(i)) for i in range(args.launch)]
+        for socket_dir in socket_dirs:
+            processes.append(bl_emulate.emulate(pathlib.Path(args.boot_path).resolve(), socket_dir=socket_dir))
+    else:
+        socket_dirs = args.attach
+    devices = [Device(os.path.basename(os.path.normpath(d)) or d, d) for d in socket_dirs]
+
+    start = time.perf_counter()
+    try:
+        asyncio.run(update_fleet(devices, images, args))
+    finally:
+        for process in processes:
+            process.terminate()
+    elapsed = time.perf_counter() - start
+
+    failed = [device for device in devices if device.error]
+    slowest = max((device.elapsed for device in devices if device.elapsed is not None), default=0.0)
+    print(f"{len(devices) - len(failed)} of {len(devices)} devices updated in {elapsed:.2f} s (slowest device {slowest:.2f} s)")
+    for device in failed:
+        print(f"  {device.name}: {device.error}")
+    raise SystemExit(len(failed))
@@ -8,27 +8,131 @@ Firmware Bundle-and-Protect Tool
 
 """
 import argparse
+import hashlib
+import json
 import struct
+import zlib
 
+import lz
 
-def protect_firmware(infile, outfile, version, message):
+FLASH_PAGESIZE = 1024
+SLOT_SIZE = 0x10000
+
+# The bootloader rejects images that run further than this past the size in
+# their metadata (MAX_MESSAGE_SIZE in bootloader.c)
+MAX_MESSAGE_SIZE = FLASH_PAGESIZE
+
+# Packed blobs start with this magic, then the usual metadata, a byte of
+# image flags, the image digest if there is one and the (possibly
+# compressed) firmware and message.
+PACKED_MAGIC = b"FWPK"
+IMAGE_FLAG_LZ = 0x01
+IMAGE_FLAG_SLOT_B = 0x02  # linked for slot B (firmware/gcc/main_b.bin)
+IMAGE_FLAG_CRC32 = 0x04
+IMAGE_FLAG_SHA256 = 0x08
+
+# Pre-framed containers (--framed) hold one image as protocol 2 frames ready
+# to go on the wire: a header, the image digest, the file offset of every
+# frame plus the end of the file, then the frames, the last one empty.
+#
+#   magic | frame size | frame count | metadata | image id | flags | digest size
+FRAMED_MAGIC = b"FWFR"
+FRAMED_HEADER = struct.Struct("<4sHI4sIBB")
+FRAME_HEADER = struct.Struct(">BH")
+
+
+def page_digests(image):
+    # SHA-256 of every flash page the image occupies, padded the way an
+    # erased page reads back.
+    digests = []
+    for start in range(0, len(image), FLASH_PAGESIZE):
+        page = image[start : start + FLASH_PAGESIZE].ljust(FLASH_PAGESIZE, b"\xff")
+        digests.append(hashlib.sha256(page).hexdigest())
+    return digests
+
+
+def write_manifest(path, version, size, image):
+    # Per-page digest manifest used by fw_update.py --delta.
+    manifest = {
+        "version": version,
+        "size": size,
+        "page_size": FLASH_PAGESIZE,
+        "pages": page_digests(image),
+    }
+    with open(path, "w") as fp:
+        json.dump(manifest, fp, indent=2)
+
+
+def image_digest(kind, image):
+    # Digest of the uncompressed firmware and message, checked by the
+    # bootloader against flash once the image is written.
+    if kind == "crc32":
+        return IMAGE_FLAG_CRC32, struct.pack("<I", zlib.crc32(image))
+    if kind == "sha256":
+        return IMAGE_FLAG_SHA256, hashlib.sha256(image).digest()
+    return 0, b""
+
+
+def frame_image(firmware_blob, metadata, flags, digest_bytes, payload, frame_size):
+    # The container for a blob. The image id is that of the blob itself, so
+    # both forms of an image resume each other's interrupted updates.
+    chunks = [payload[i : i + frame_size] for i in range(0, len(payload), frame_size)]
+    chunks.append(b"")
+    frames = [FRAME_HEADER.pack(idx & 0xFF, len(chunk)) + chunk for idx, chunk in enumerate(chunks)]
+
+    offset = FRAMED_HEADER.size + len(digest_bytes) + 4 * (len(frames) + 1)
+    offsets = []
+    for frame in frames:
+        offsets.append(offset)
+        offset += len(frame)
+    offsets.append(offset)
+
+    header = FRAMED_HEADER.pack(FRAMED_MAGIC, frame_size, len(frames), metadata, zlib.crc32(firmware_blob), flags, len(digest_bytes))
+    return header + digest_bytes + struct.pack(f"<{len(offsets)}I", *offsets) + b"".join(frames)
+
+
+def protect_firmware(infile, outfile, version, message, manifest=None, compress=False, slot="a", digest="none", framed=None):
     # Load firmware binary from infile
     with open(infile, 'rb') as fp:
         firmware = fp.read()
 
     # Append null-terminated message to end of firmware
     firmware_and_message = firmware + message.encode() + b'\00'
+    if len(message.encode()) + 1 > MAX_MESSAGE_SIZE:
+        raise ValueError(f"Release message must be under {MAX_MESSAGE_SIZE} bytes")
+    if len(firmware_and_message) > SLOT_SIZE:
+        raise ValueError(f"Firmware and message must fit in a {SLOT_SIZE} byte slot")
 
     # Pack version and size into two little-endian shorts
     metadata = struct.pack('<HH', version, len(firmware))
 
-    # Append firmware and message to metadata
-    firmware_blob = metadata + firmware_and_message
+    # Append firmware and message to metadata. Slot B images and images with
+    # a digest use the packed form so the flags travel with them.
+    flags, digest_bytes = image_digest(digest, firmware_and_message)
+    if slot == "b":
+        flags |= IMAGE_FLAG_SLOT_B
+    if compress:
+        packed = lz.compress(firmware_and_message)
+        print(f"Compressed {len(firmware_and_message)} bytes to {len(packed)} bytes")
+        flags |= IMAGE_FLAG_LZ
+    else:
+        packed = firmware_and_message
+
+    if flags:
+        firmware_blob = PACKED_MAGIC + metadata + struct.pack("<B", flags) + digest_bytes + packed
+    else:
+        firmware_blob = metadata + firmware_and_message
+
+    if framed is not None:
+        firmware_blob = frame_image(firmware_blob, metadata, flags, digest_bytes, packed, framed)
 
     # Write firmware blob to outfile
     with open(outfile, 'wb+') as outfile:
         outfile.write(firmware_blob)
 
+    if manifest is not None:
+        write_manifest(manifest, version, len(firmware), firmware_and_message)
+
 
 if __name__ == '__main__':
     parser = argparse.ArgumentParser(description='Firmware Update Tool')
@@ -36,6 +140,21 @@ if __name__ == '__main__':
     parser.add_argument("--outfile", help="Filename for the output firmware.", required=True)
     parser.add_argument("--version", help="Version number of this firmware.", required=True)
     parser.add_argument("--message", help="Release message for this firmware.", required=True)
+    parser.add_argument("--manifest", help="Also write a per-page digest manifest for delta updates.", default=None)
+    parser.add_argument("--compress", help="Compress the firmware and message (protocol 2 only).", action="store_true")
+    parser.add_argument("--slot", help="Slot the firmware was linked for (b: firmware/gcc/main_b.bin).", choices=["a", "b"], default="a")
+    parser.add_argument("--digest", help="Whole-image digest for the bootloader to check (protocol 2 only).", choices=["none", "crc32", "sha256"], default="none")
+    parser.add_argument("--framed", help="Write a pre-framed container with frames of this size (protocol 2 only).", type=int, nargs="?", const=1024, default=None)
     args = parser.parse_args()
 
-    protect_firmware(infile=args.infile, outfile=args.outfile, version=int(args.version), message=args.message)
+    protect_firmware(
+        infile=args.infile,
+        outfile=args.outfile,
+        version=int(args.version),
+        message=args.message,
+        manifest=args.manifest,
+        compress=args.compress,
+        slot=args.slot,
+        digest=args.digest,
+        framed=args.framed,
+    )
@@ -20,18 +20,199 @@ In our case, the data is from one line of the Intel Hex formated .hex file
 We write a frame to the bootloader, then wait for it to respond with an
 OK message so we can write the next frame. The OK message in this case is
 just a zero
+
+Protocol version 2 (the default) is entered with a "V" handshake instead of
+"U". The bootloader answers with its protocol version, the largest window
+and the largest frame it accepts. Frames carry a sequence number:
+
+[ 0x01 ] [ 0x02 ]  [ variable ]
+------------------------------
+|  Seq  | Length | Data...   |
+------------------------------
+
+The metadata is followed by a byte of image flags and a 32-bit image
+identity (the CRC32 of the blob). Flag bit 0 marks an LZSS compressed image
+(fw_protect.py --compress) that the bootloader decodes as it arrives. Blobs
+made with fw_protect.py --digest carry a CRC-32 or SHA-256 of the image,
+which is sent next; the bootloader folds each page into it as read back
+from flash and only accepts the image if it matches, in place of the
+per-page compare. Without --compress, --digest or --slot b, fw_protect.py
+writes the plain blob protocol 1 expects.
+
+The bootloader acknowledges the metadata with OK and a 32-bit resume
+offset: the number of bytes of this image it already committed in an
+interrupted session. Frames restart from that offset with sequence number
+zero, so with --retries a failed transfer resumes instead of starting over.
+Up to a window of frames are sent before waiting, and every frame is
+answered with [ OK ] [ seq ]. Acknowledgements are cumulative, so an OK for
+frame n also covers every frame before it. Frames may be as large as a full
+1 KB flash page. Use --protocol 1 to talk to bootloaders that only know the
+lock-step mode.
+
+Delta updates (--delta) use a "D" handshake. After the metadata the host
+sends the image's IMAGE_FLAG_SLOT_B and its page count. The bootloader
+reports the SHA-256 of each installed page and only pages whose digest
+differs from the manifest written by fw_protect.py --manifest are sent:
+
+[ 0x02 ]  [ 0x02 ]  [ variable ]
+---------------------------------
+|  Page  | Length |  Data...    |
+---------------------------------
+
+The bootloader keeps two firmware slots and writes protocol 2 and delta
+updates to the one that is not running, switching over only once the new
+image is complete. It announces that slot during the handshake; images are
+linked for the slot they run from, so pass the slot A build as --firmware
+and the slot B build (fw_protect.py --slot b) as --firmware-b and the
+matching one is sent. Protocol 1 always installs in place to slot A.
+--rollback switches back to the previously running slot.
+
+--baud raises the line rate for the update with an "S" exchange before the
+handshake: the rate is sent as a little endian word, the bootloader answers
+OK and switches, and the host switches too and sends "SYNC" at the new rate.
+A second OK confirms it; without one both sides return to 115200. The
+bootloader also returns to 115200 when the update ends.
+
+fw_protect.py --framed writes an image as a pre-framed container instead:
+the protocol 2 frames, sequence numbers included, stored back to back after
+a table of their offsets. Such an image is mapped rather than read, and its
+frames go from the page cache to the socket with sendfile, a window at a
+time. It is sent in the frame size it was built with (--frame-size does not
+apply) unless the bootloader takes smaller frames or resumes mid-frame, in
+which case it is framed again.
+
+After an update the bootloader is asked ("P") for a cycle profile of it,
+which is printed as a breakdown by phase (receiving, flash compare, erase,
+program, read-back verification and bookkeeping) and by page.
 """
 
 import argparse
+import contextlib
+import json
+import mmap
 import struct
 import time
 import socket
+import zlib
 
 from util import *
 
 RESP_OK = b"\x00"
 FRAME_SIZE = 256
 
+V2_FRAME_SIZE = 1024
+V2_WINDOW = 4
+RETRY_DELAY = 1.0
+
+DEFAULT_BAUD = 115200
+BAUD_CONFIRM = b"SYNC"
+BAUD_SETTLE = 0.05
+BAUD_CONFIRM_TIMEOUT = 1.0
+
+FLASH_PAGESIZE = 1024
+PAGE_DIGEST_SIZE = 32
+END_OF_PAGES = 0xFFFF
+
+PACKED_MAGIC = b"FWPK"
+IMAGE_FLAG_LZ = 0x01
+IMAGE_FLAG_SLOT_B = 0x02
+IMAGE_FLAG_CRC32 = 0x04
+IMAGE_FLAG_SHA256 = 0x08
+SLOT_NAMES = "AB"
+
+PROFILE_PHASES = ["receive", "compare", "erase", "program", "verify", "other"]
+
+# Protocol 2 capabilities: version, window, frame size and slot.
+V2_CAPS = struct.Struct("<BBHB")
+
+# Frame headers; the payload follows as a separate buffer (see writev()).
+V2_FRAME_HEADER = struct.Struct(">BH")
+DELTA_FRAME_HEADER = struct.Struct(">HH")
+
+# Pre-framed containers (fw_protect.py --framed).
+FRAMED_MAGIC = b"FWFR"
+FRAMED_HEADER = struct.Struct("<4sHI4sIBB")
+
+
+class FramedImage:
+    # A pre-framed container, mapped instead of read: protocol 2 frames
+    # stored back to back, ready to send, with a table of their offsets.
+    def __init__(self, path):
+        self.file = open(path, "rb")
+        self.map = mmap.mmap(self.file.fileno(), 0, access=mmap.ACCESS_READ)
+        self.view = memoryview(self.map)
+
+        _, self.frame_size, self.frame_count, self.metadata, self.image_id, self.flags, digest_size = FRAMED_HEADER.unpack_from(self.map)
+        self.digest = bytes(self.map[FRAMED_HEADER.size : FRAMED_HEADER.size + digest_size])
+        self.offsets = struct.unpack_from(f"<{self.frame_count + 1}I", self.map, FRAMED_HEADER.size + digest_size)
+        self.size = self.offsets[-1] - self.offsets[0] - V2_FRAME_HEADER.size * self.frame_count
+
+    def data(self, idx):
+        return self.view[self.offsets[idx] + V2_FRAME_HEADER.size : self.offsets[idx + 1]]
+
+    def payload(self):
+        return b"".join(self.data(idx) for idx in range(self.frame_count))
+
+
+def parse_blob(firmware_blob):
+    # Split a blob into metadata, image flags, image digest and payload.
+    # Plain blobs (fw_protect.py's default) have no magic and no flags.
+    if firmware_blob.startswith(PACKED_MAGIC):
+        header = len(PACKED_MAGIC)
+        flags = firmware_blob[header + 4]
+        digest_size = 4 if flags & IMAGE_FLAG_CRC32 else 32 if flags & IMAGE_FLAG_SHA256 else 0
+        digest = firmware_blob[header + 5 : header + 5 + digest_size]
+        return firmware_blob[header : header + 4], flags, digest, firmware_blob[header + 5 + digest_size :]
+    return firmware_blob[:4], 0, b"", firmware_blob[4:]
+
+
+def load_images(paths, manifests):
+    # Read each blob and key it by the slot it was linked for.
+    images = {}
+    for path, manifest in zip(paths, manifests):
+        with open(path, "rb") as fp:
+            framed = fp.read(len(FRAMED_MAGIC)) == FRAMED_MAGIC
+        if framed:
+            framed = FramedImage(path)
+            images[1 if framed.flags & IMAGE_FLAG_SLOT_B else 0] = {
+                "manifest": manifest or path + ".manifest",
+                "metadata": framed.metadata,
+                "flags": framed.flags,
+                "digest": framed.digest,
+                "firmware": None,
+                "framed": framed,
+                "size": framed.size,
+                "image_id": framed.image_id,
+            }
+            continue
+
+        with open(path, "rb") as fp:
+            firmware_blob = fp.read()
+        metadata, flags, digest, firmware = parse_blob(firmware_blob)
+        slot = 1 if flags & IMAGE_FLAG_SLOT_B else 0
+        images[slot] = {
+            "manifest": manifest or path + ".manifest",
+            "metadata": metadata,
+            "flags": flags,
+            "digest": digest,
+            "firmware": firmware,
+            "framed": None,
+            "size": len(firmware),
+            "image_id": zlib.crc32(firmware_blob),
+        }
+    return images
+
+
+def select_image(images, slot):
+    # The image for the slot the bootloader announced. If there is none, send
+    # what we have anyway: its IMAGE_FLAG_SLOT_B does not match, so the
+    # bootloader rejects it and resets.
+    if slot not in images:
+        print(f"No image linked for slot {SLOT_NAMES[slot]} (see --firmware-b), the bootloader will reject it")
+        return next(iter(images.values()))
+    print(f"Bootloader is writing slot {SLOT_NAMES[slot]}")
+    return images[slot]
+
 
 def send_metadata(ser, metadata, debug=False):
     version, size = struct.unpack_from("<HH", metadata)
@@ -74,13 +255,96 @@ def send_frame(ser, frame, debug=False):
         print("Resp: {}".format(ord(resp)))
 
 
-def update(ser, infile, debug):
-    # Open serial port. Set baudrate to 115200. Set timeout to 2 seconds.
-    with open(infile, "rb") as fp:
-        firmware_blob = fp.read()
+def negotiate_baud(ser, baud):
+    # Ask the bootloader to switch the link to baud, confirm it at the new
+    # rate and fall back to the default if that fails. Returns the rate in use.
+    ser.write(b"S")
+
+    while ser.read(1) != b"S":
+        print("got a byte")
+        pass
+
+    ser.write(struct.pack("<I", baud))
+    resp = ser.read(1)
+    if resp != RESP_OK:
+        print(f"Bootloader cannot run at {baud} baud, staying at {DEFAULT_BAUD}")
+        return DEFAULT_BAUD
+
+    ser.baudrate = baud
+    time.sleep(BAUD_SETTLE)
+    ser.write(BAUD_CONFIRM)
+
+    timeout = ser.timeout
+    ser.timeout = BAUD_CONFIRM_TIMEOUT
+    try:
+        resp = ser.read(1)
+    except OSError:
+        resp = b""
+    finally:
+        ser.timeout = timeout
+
+    if resp != RESP_OK:
+        print(f"No confirmation at {baud} baud, falling back to {DEFAULT_BAUD}")
+        ser.baudrate = DEFAULT_BAUD
+        ser.flush_input()
+        return DEFAULT_BAUD
+
+    print(f"Switched to {baud} baud")
+    return baud
+
 
-    metadata = firmware_blob[:4]
-    firmware = firmware_blob[4:]
+@contextlib.contextmanager
+def line_rate(ser, baud, image_size):
+    # Run one update session at baud (if the bootloader agrees) and report its
+    # throughput. The bootloader returns to the default rate when an update
+    # ends or fails (it resets), so the host always does too.
+    if baud != DEFAULT_BAUD:
+        baud = negotiate_baud(ser, baud)
+
+    start = time.perf_counter()
+    try:
+        yield
+    finally:
+        ser.baudrate = DEFAULT_BAUD
+
+    elapsed = time.perf_counter() - start
+    print(f"Updated {image_size} bytes at {baud} baud in {elapsed:.2f} s ({image_size / elapsed / 1024:.1f} KB/s)")
+
+
+def update(ser, infile, debug, protocol=2, window=V2_WINDOW, frame_size=V2_FRAME_SIZE, delta=False, retries=0, infile_b=None, manifest=None, baud=DEFAULT_BAUD, frame_times=None):
+    # Open serial port. Set baudrate to 115200. Set timeout to 2 seconds.
+    images = load_images([infile] + ([infile_b] if infile_b else []), [manifest, None])
+    image_size = max(image["size"] for image in images.values())
+
+    if any(image["flags"] & IMAGE_FLAG_LZ for image in images.values()) and (protocol != 2 or delta):
+        raise RuntimeError("ERROR: Compressed images need protocol 2 and cannot be sent as a delta")
+    if any(image["framed"] for image in images.values()) and (protocol != 2 or delta):
+        raise RuntimeError("ERROR: Pre-framed images need protocol 2 and cannot be sent as a delta")
+
+    if delta:
+        with line_rate(ser, baud, image_size):
+            return update_delta(ser, images, debug)
+
+    if protocol == 2:
+        for attempt in range(retries + 1):
+            try:
+                with line_rate(ser, baud, image_size):
+                    return update_v2(ser, images, window, frame_size, debug, frame_times)
+            except (RuntimeError, OSError) as e:
+                if attempt == retries:
+                    raise
+                print(f"Update interrupted ({e}), retrying...")
+                time.sleep(RETRY_DELAY)
+                ser.flush_input()
+
+    with line_rate(ser, baud, image_size):
+        return update_v1(ser, images, debug)
+
+
+def update_v1(ser, images, debug):
+    if 0 not in images:
+        raise RuntimeError("ERROR: Protocol 1 only installs slot A images")
+    metadata, firmware = images[0]["metadata"], images[0]["firmware"]
 
     send_metadata(ser, metadata, debug=debug)
 
@@ -109,32 +373,358 @@ def update(ser, infile, debug):
     return ser
 
 
+def v2_metadata(image):
+    # What the host sends after the capabilities: metadata, image flags,
+    # image identity and image digest.
+    return image["metadata"] + struct.pack("<BI", image["flags"], image["image_id"]) + image["digest"]
+
+
+def send_metadata_v2(ser, images, debug=False):
+    # Handshake for a windowed update
+    ser.write(b"V")
+
+    print("Waiting for bootloader to enter update mode...")
+    while ser.read(1) != b"V":
+        print("got a byte")
+        pass
+
+    # Bootloader advertises protocol version, window, frame size and slot.
+    proto, max_window, max_frame, slot = V2_CAPS.unpack(ser.read(V2_CAPS.size))
+    if debug:
+        print(f"Bootloader protocol {proto}, window {max_window}, frame size {max_frame}")
+
+    image = select_image(images, slot)
+    metadata = image["metadata"]
+    version, size = struct.unpack_from("<HH", metadata)
+    print(f"Version: {version}\nSize: {size} bytes\n")
+
+    ser.write(v2_metadata(image))
+
+    # Wait for an OK from the bootloader, then the resume offset.
+    resp = ser.read(1)
+    if resp != RESP_OK:
+        raise RuntimeError("ERROR: Bootloader responded with {}".format(repr(resp)))
+    (resume,) = struct.unpack("<I", ser.read(4))
+
+    return image, max_window, max_frame, resume
+
+
+def check_ack(ack):
+    # Check one [ status ] [ seq ] acknowledgement and return its seq.
+    resp, seq = ack
+    if bytes([resp]) != RESP_OK:
+        raise RuntimeError("ERROR: Bootloader responded with {} at frame {}".format(repr(bytes([resp])), seq))
+    return seq
+
+
+def read_ack(ser):
+    return check_ack(ser.read(2))
+
+
+class V2Transfer:
+    # The frames of a protocol 2 update and the window sliding over them,
+    # without the I/O, which update_v2() and fw_fleet.py each do their own
+    # way. Frames count from 0 at the resume point, and their sequence
+    # numbers are the low byte of that count.
+    def __init__(self, image, window, frame_size, max_window, max_frame, resume, log=print):
+        if resume > image["size"]:
+            raise RuntimeError(f"ERROR: Bootloader asked to resume past the end of the image ({resume})")
+        self.window = max(1, min(window, max_window))
+        self.frame_size = max(1, min(frame_size, max_frame))
+        self.resume = resume
+        self.size = image["size"]
+
+        # Pre-framed images are sent as stored, in their own frame size, as
+        # long as the bootloader takes frames that large and any resume point
+        # falls on a frame boundary. Otherwise their data is framed again like
+        # a blob.
+        framed = image["framed"]
+        if framed is not None and (framed.frame_size > max_frame or resume % framed.frame_size):
+            log(f"Cannot send the stored {framed.frame_size} byte frames here, framing the image again")
+            firmware = memoryview(framed.payload())
+            framed = None
+        elif framed is None:
+            firmware = memoryview(image["firmware"])
+
+        self.framed = framed
+        if framed is not None:
+            self.frame_size = framed.frame_size
+            self.first = resume // framed.frame_size
+            self.chunks = [framed.data(idx) for idx in range(self.first, framed.frame_count)]
+        else:
+            # The last frame is the zero length frame that ends the transfer.
+            firmware = firmware[resume:]
+            self.chunks = [firmware[i : i + self.frame_size] for i in range(0, len(firmware), self.frame_size)]
+            self.chunks.append(b"")
+
+        self.base = 0  # oldest unacknowledged frame
+        self.next = 0  # next frame to send
+
+    def done(self):
+        return self.base >= len(self.chunks)
+
+    def pending(self):
+        # The frames the window has room for now, in the order to send them.
+        return range(self.next, min(len(self.chunks), self.base + self.window))
+
+    def stored_span(self, frames):
+        # Offset and length in the framed file of frames as stored, sequence
+        # numbers included, or None if they have to be sent one by one. The
+        # stored sequence numbers count from the start of the image, so only
+        # a transfer from the start can use them.
+        if self.framed is None or self.first or not frames:
+            return None
+        offsets = self.framed.offsets
+        return offsets[frames.start], offsets[frames.stop] - offsets[frames.start]
+
+    def frame(self, idx):
+        # Header and data of one frame.
+        data = self.chunks[idx]
+        return V2_FRAME_HEADER.pack(idx & 0xFF, len(data)), data
+
+    def sent(self, frames):
+        self.next = frames.stop
+
+    def ack(self, seq):
+        # Cumulative acknowledgement: slide the window past the frame seq
+        # acknowledges. Returns the frames it newly covers.
+        acked = self.base + ((seq - self.base) & 0xFF)
+        if acked >= self.next:
+            raise RuntimeError(f"ERROR: Bootloader acknowledged unsent frame {seq}")
+        covered = range(self.base, acked + 1)
+        self.base = acked + 1
+        return covered
+
+    def acked_bytes(self):
+        # Bytes of the image the bootloader has taken so far.
+        return min(self.size, self.resume + self.base * self.frame_size)
+
+
+def update_v2(ser, images, window, frame_size, debug, frame_times=None):
+    # frame_times, if given, collects the seconds from sending each frame to
+    # the acknowledgement that covered it.
+    image, max_window, max_frame, resume = send_metadata_v2(ser, images, debug=debug)
+    transfer = V2Transfer(image, window, frame_size, max_window, max_frame, resume)
+    if resume:
+        print(f"Resuming at byte {resume} of {image['size']}")
+
+    sent_at = [0.0] * len(transfer.chunks)
+    while not transfer.done():
+        # Fill the window.
+        frames = transfer.pending()
+        stored = transfer.stored_span(frames)
+        if stored is not None:
+            # The stored frames are back to back in the file: send the batch
+            # from the page cache in one go.
+            ser.sendfile(transfer.framed.file, *stored)
+        for idx in frames:
+            header, data = transfer.frame(idx)
+            if stored is None:
+                ser.writev((header, data))
+            sent_at[idx] = time.perf_counter()
+            if debug:
+                print_hex(header + data)
+            print(f"Wrote frame {idx} ({len(header) + len(data)} bytes)")
+        transfer.sent(frames)
+
+        covered = transfer.ack(read_ack(ser))
+        if frame_times is not None:
+            now = time.perf_counter()
+            frame_times.extend(now - sent_at[i] for i in covered)
+
+    print("Done writing firmware.")
+
+    return ser
+
+
+def update_delta(ser, images, debug):
+    # Handshake for a delta update
+    ser.write(b"D")
+
+    print("Waiting for bootloader to enter update mode...")
+    while ser.read(1).decode() != "D":
+        print("got a byte")
+        pass
+
+    # The bootloader compares against, and writes to, the slot it announces.
+    # The page digests are only meaningful for the image linked for it.
+    slot = ser.read(1)[0]
+    if slot not in images:
+        raise RuntimeError(f"ERROR: No image linked for slot {SLOT_NAMES[slot]} (see --firmware-b)")
+    image = select_image(images, slot)
+    metadata, firmware = image["metadata"], image["firmware"]
+
+    with open(image["manifest"]) as fp:
+        manifest = json.load(fp)
+
+    version, size = struct.unpack_from("<HH", metadata)
+    if (manifest["version"], manifest["size"], manifest["page_size"]) != (version, size, FLASH_PAGESIZE):
+        raise RuntimeError("ERROR: Manifest does not describe this firmware blob")
+    pages = manifest["pages"]
+
+    print(f"Version: {version}\nSize: {size} bytes\n")
+
+    ser.write(metadata + struct.pack("<BH", image["flags"] & IMAGE_FLAG_SLOT_B, len(pages)))
+
+    resp = ser.read(1)
+    if resp != RESP_OK:
+        raise RuntimeError("ERROR: Bootloader responded with {}".format(repr(resp)))
+
+    # Collect the digests of the pages currently installed.
+    installed = []
+    for _ in pages:
+        installed.append(ser.read(PAGE_DIGEST_SIZE).hex())
+
+    changed = [idx for idx, digest in enumerate(pages) if installed[idx] != digest]
+    print(f"{len(changed)} of {len(pages)} pages changed")
+
+    firmware = memoryview(firmware)
+    for idx in changed:
+        data = firmware[idx * FLASH_PAGESIZE : (idx + 1) * FLASH_PAGESIZE]
+        header = DELTA_FRAME_HEADER.pack(idx, len(data))
+        ser.writev((header, data))
+        if debug:
+            print_hex(header + data)
+
+        resp = ser.read(1)
+        if resp != RESP_OK:
+            raise RuntimeError("ERROR: Bootloader responded to page {} with {}".format(idx, repr(resp)))
+        print(f"Wrote page {idx} ({len(header) + len(data)} bytes)")
+
+    ser.write(struct.pack(">HH", END_OF_PAGES, 0))
+    resp = ser.read(1)
+    if resp != RESP_OK:
+        raise RuntimeError("ERROR: Bootloader responded to end of pages with {}".format(repr(resp)))
+
+    print("Done writing firmware.")
+
+    return ser
+
+
+def read_profile(ser):
+    # Fetch the cycle profile of the last update: the clock, cycles per phase
+    # and flash cycles per page of the slot that was written.
+    ser.write(b"P")
+
+    while ser.read(1) != b"P":
+        print("got a byte")
+        pass
+
+    clock, phase_count = struct.unpack("<IB", ser.read(5))
+    phases = struct.unpack(f"<{phase_count}Q", ser.read(8 * phase_count))
+    (page_count,) = struct.unpack("<H", ser.read(2))
+    pages = struct.unpack(f"<{page_count}I", ser.read(4 * page_count))
+    return clock, phases, pages
+
+
+def print_profile(ser):
+    clock, phases, pages = read_profile(ser)
+    total = sum(phases) or 1
+
+    print(f"Bootloader profile ({clock / 1e6:.1f} MHz, {total / clock:.3f} s):")
+    for i, cycles in enumerate(phases):
+        name = PROFILE_PHASES[i] if i < len(PROFILE_PHASES) else f"phase {i}"
+        print(f"  {name:<8} {cycles:>12} cycles {cycles / clock * 1e3:>10.1f} ms {100 * cycles / total:>6.1f}%")
+
+    written = [(page, cycles) for page, cycles in enumerate(pages) if cycles]
+    if written:
+        slowest, slowest_cycles = max(written, key=lambda p: p[1])
+        mean = sum(cycles for _, cycles in written) / len(written)
+        print(f"  {len(written)} pages written, {mean / clock * 1e3:.2f} ms per page on average, "
+              f"slowest page {slowest} at {slowest_cycles / clock * 1e3:.2f} ms")
+
+
+def set_log_level(ser, level):
+    # Change how much the bootloader logs on UART2 (0: nothing, 4: debug).
+    ser.write(b"L")
+
+    while ser.read(1).decode() != "L":
+        print("got a byte")
+        pass
+
+    ser.write(struct.pack("<B", level))
+    resp = ser.read(1)
+    if resp != RESP_OK:
+        raise RuntimeError(f"ERROR: Bootloader rejected log level {level}")
+
+    return ser
+
+
+def rollback(ser):
+    # Switch the bootloader back to the slot that ran before the last update.
+    ser.write(b"R")
+
+    while ser.read(1).decode() != "R":
+        print("got a byte")
+        pass
+
+    resp = ser.read(1)
+    if resp != RESP_OK:
+        raise RuntimeError("ERROR: Bootloader has no other firmware to roll back to")
+    print("Rolled back to the previous firmware.")
+
+    return ser
+
+
 if __name__ == "__main__":
     parser = argparse.ArgumentParser(description="Firmware Update Tool")
 
     parser.add_argument("--port", help="Does nothing, included to adhere to command examples in rule doc", required=False)
     parser.add_argument("--firmware", help="Path to firmware image to load.", required=False)
     parser.add_argument("--debug", help="Enable debugging messages.", action="store_true")
+    parser.add_argument("--protocol", help="Update protocol (1: lock-step, 2: windowed).", type=int, choices=[1, 2], default=2)
+    parser.add_argument("--window", help="Frames in flight for protocol 2.", type=int, default=V2_WINDOW)
+    parser.add_argument("--frame-size", help="Frame data size for protocol 2.", type=int, default=V2_FRAME_SIZE)
+    parser.add_argument("--retries", help="Resume an interrupted protocol 2 update this many times.", type=int, default=0)
+    parser.add_argument("--timeout", help="Seconds to wait for the bootloader before giving up.", type=float, default=None)
+    parser.add_argument("--delta", help="Only send pages that differ from the installed firmware.", action="store_true")
+    parser.add_argument("--manifest", help="Digest manifest of --firmware for --delta (default: <firmware>.manifest).", default=None)
+    parser.add_argument("--firmware-b", help="The same firmware linked for slot B (fw_protect.py --slot b).", default=None)
+    parser.add_argument("--rollback", help="Switch back to the previously running firmware.", action="store_true")
+    parser.add_argument("--log-level", help="Bootloader debug log level for this session (0: off .. 4: debug).", type=int, choices=range(5), default=None)
+    parser.add_argument("--baud", help="Baud rate to negotiate for the update (falls back to 115200).", type=int, default=DEFAULT_BAUD)
+    parser.add_argument("--socket-dir", help="UART socket directory of the emulator (bl_emulate.py --socket-dir).", default=None)
     args = parser.parse_args()
+    uart0_path, uart1_path, uart2_path = uart_paths(args.socket_dir)
 
     uart0_sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
-    uart0_sock.connect(UART0_PATH)
+    uart0_sock.connect(uart0_path)
 
     time.sleep(0.2)  # QEMU takes a moment to open the next socket
 
     uart1_sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
-    uart1_sock.connect(UART1_PATH)
+    uart1_sock.connect(uart1_path)
+    uart1_sock.settimeout(args.timeout)
     uart1 = DomainSocketSerial(uart1_sock)
 
     time.sleep(0.2)
 
     uart2_sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
-    uart2_sock.connect(UART2_PATH)
+    uart2_sock.connect(uart2_path)
 
     # Close unused UARTs (if we leave these open it will hang)
     uart2_sock.close()
     uart0_sock.close()
 
-    update(ser=uart1, infile=args.firmware, debug=args.debug)
+    if args.log_level is not None:
+        set_log_level(uart1, args.log_level)
+
+    if args.rollback:
+        rollback(uart1)
+    else:
+        update(
+            ser=uart1,
+            infile=args.firmware,
+            debug=args.debug,
+            protocol=args.protocol,
+            window=args.window,
+            frame_size=args.frame_size,
+            delta=args.delta,
+            retries=args.retries,
+            infile_b=args.firmware_b,
+            manifest=args.manifest,
+            baud=args.baud,
+        )
+        print_profile(uart1)
 
     uart1_sock.close()
@@ -0,0 +1,148 @@
+#!/usr/bin/env python
+
+# Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+# Approved for public release. Distribution unlimited 23-02181-13.
+
+"""
+Diagnostics Shell Command Table Generator
+
+Reads COMMAND(name, handler) entries from one or more .def files and writes
+a C header with a minimal perfect hash over the names, so the firmware can
+dispatch a command with two hashes and one compare however many commands
+there are. The firmware Makefile runs this whenever a .def file changes:
+
+    python gen_commands.py --out ../firmware/lib/command_table.h \\
+        ../firmware/lib/commands.def ../firmware/src/commands.def
+
+The hash is hash-and-displace: the first hash picks a bucket, and each
+bucket stores the seed for a second hash that sends every name in it to a
+free slot. firmware/lib/commands.c must hash the same way as command_hash().
+"""
+import argparse
+import os
+import re
+
+FNV_BASIS = 0x811C9DC5
+FNV_PRIME = 0x01000193
+MAX_DISPLACEMENT = 0xFFFF
+
+COMMAND_RE = re.compile(r'^\s*COMMAND\(\s*"([^"\\]+)"\s*,\s*(\w+)\s*\)', re.MULTILINE)
+
+
+def command_hash(name, seed):
+    # 32-bit FNV-1a with the seed as the offset basis. The high half is folded
+    # in at the end since the table index comes from the low bits, which on
+    # their own depend only on the low bits of the seed.
+    h = seed
+    for c in name.encode():
+        h = ((h ^ c) * FNV_PRIME) & 0xFFFFFFFF
+    return h ^ (h >> 16)
+
+
+def next_pow2(n):
+    p = 1
+    while p < n:
+        p <<= 1
+    return p
+
+
+def read_commands(paths):
+    commands = []
+    for path in paths:
+        with open(path) as fp:
+            commands += COMMAND_RE.findall(fp.read())
+
+    names = [name for name, _ in commands]
+    duplicates = sorted({name for name in names if names.count(name) > 1})
+    if duplicates:
+        raise ValueError(f"Duplicate commands: {', '.join(duplicates)}")
+    return commands
+
+
+def build_table(names):
+    # Returns (buckets, slots, displacement per bucket, slot of each name).
+    buckets = next_pow2(max(1, len(names) // 2))
+    slots = next_pow2(max(2, len(names) + len(names) // 4))
+
+    members = [[] for _ in range(buckets)]
+    for name in names:
+        members[command_hash(name, FNV_BASIS) & (buckets - 1)].append(name)
+
+    displacement = [0] * buckets
+    placed = {}
+    used = set()
+    # Largest buckets first, while there is the most room to place them.
+    for bucket in sorted(range(buckets), key=lambda b: -len(members[b])):
+        if not members[bucket]:
+            continue
+        for seed in range(1, MAX_DISPLACEMENT + 1):
+            wanted = [command_hash(name, seed) & (slots - 1) for name in members[bucket]]
+            if len(set(wanted)) == len(wanted) and used.isdisjoint(wanted):
+                break
+        else:
+            raise RuntimeError(f"No displacement places bucket {bucket}")
+        displacement[bucket] = seed
+        placed.update(zip(members[bucket], wanted))
+        used.update(wanted)
+
+    return buckets, slots, displacement, placed
+
+
+def write_header(path, commands, sources):
+    names = [name for name, _ in commands]
+    buckets, slots, displacement, placed = build_table(names)
+    by_slot = {placed[name]: (name, handler) for name, handler in commands}
+
+    lines = [
+        "// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED",
+        "// Approved for public release. Distribution unlimited 23-02181-13.",
+        "",
+        f"// Generated by tools/gen_commands.py from {', '.join(sources)}.",
+        "// Do not edit; change the .def files and rebuild.",
+        "",
+        "#ifndef COMMAND_TABLE_H",
+        "#define COMMAND_TABLE_H",
+        "",
+        '#include "commands.h"',
+        "",
+        f"#define COMMAND_COUNT {len(commands)}",
+        f"#define COMMAND_BUCKETS {buckets}",
+        f"#define COMMAND_SLOTS {slots}",
+        "",
+    ]
+    for handler in sorted({handler for _, handler in commands}):
+        lines.append(f"void {handler}(char *buffer);")
+    lines += [
+        "",
+        "static const uint16_t command_displacement[COMMAND_BUCKETS] = {",
+    ]
+    for start in range(0, buckets, 12):
+        lines.append("    " + ", ".join(str(d) for d in displacement[start : start + 12]) + ",")
+    lines += [
+        "};",
+        "",
+        "static const command_t command_table[COMMAND_SLOTS] = {",
+    ]
+    for slot in sorted(by_slot):
+        name, handler = by_slot[slot]
+        lines.append(f'    [{slot}] = {{ "{name}", {len(name)}, {handler} }},')
+    lines += [
+        "};",
+        "",
+        "#endif",
+        "",
+    ]
+
+    with open(path, "w") as fp:
+        fp.write("\n".join(lines))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Diagnostics Shell Command Table Generator")
+    parser.add_argument("defs", help="COMMAND(name, handler) definition files.", nargs="+")
+    parser.add_argument("--out", help="Header to write.", required=True)
+    args = parser.parse_args()
+
+    # Name the sources by their last two components, e.g. lib/commands.def
+    sources = [os.path.join(*os.path.normpath(path).split(os.sep)[-2:]) for path in args.defs]
+    write_header(args.out, read_commands(args.defs), sources)
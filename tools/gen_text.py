@@ -0,0 +1,281 @@
+#!/usr/bin/env python
+
+# Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+# Approved for public release. Distribution unlimited 23-02181-13.
+
+"""
+Diagnostics Shell Text Table Generator
+
+Reads TEXT(name, "...") entries from one or more .def files and writes them
+compressed into a C table, so the firmware image carries (and an update
+sends) far fewer bytes of banner and help text. The firmware Makefile runs
+this whenever a .def file changes:
+
+    python gen_text.py --header ../firmware/lib/text_table.h \\
+        --source ../firmware/lib/text_table.c ../firmware/lib/text.def
+
+Each text is a sequence of codes ended by 0x00:
+
+    0x01 - 0x7F   the character itself
+    0x80 - 0xBF   a run: the next byte repeated RUN_MIN + (code - 0x80) times
+    0xC0 - 0xFF   dictionary entry (code - 0xC0)
+
+Dictionary entries are plain characters, picked greedily as the substrings
+that save the most. firmware/lib/text.c must decode the same way as
+decode() here.
+"""
+import argparse
+import os
+import re
+
+RUN_CODE = 0x80
+DICT_CODE = 0xC0
+RUN_MIN = 3
+RUN_MAX = RUN_MIN + (DICT_CODE - RUN_CODE) - 1
+DICT_MAX = 0x100 - DICT_CODE
+ENTRY_MAX = 32      # longest dictionary entry
+CANDIDATES = 256    # substrings counted exactly in each round
+
+TEXT_RE = re.compile(r'^\s*TEXT\(\s*(\w+)\s*,((?:\s*"(?:[^"\\]|\\.)*")+)\s*\)', re.MULTILINE)
+LITERAL_RE = re.compile(r'"((?:[^"\\]|\\.)*)"')
+ESCAPES = {"n": "\n", "t": "\t", "r": "\r", "\\": "\\", '"': '"', "'": "'"}
+
+
+def unescape(literal):
+    out = []
+    i = 0
+    while i < len(literal):
+        c = literal[i]
+        if c == "\\":
+            i += 1
+            if literal[i] not in ESCAPES:
+                raise ValueError(f"Unsupported escape \\{literal[i]}")
+            c = ESCAPES[literal[i]]
+        out.append(c)
+        i += 1
+    return "".join(out)
+
+
+def read_texts(paths):
+    texts = []
+    for path in paths:
+        with open(path) as fp:
+            for name, literals in TEXT_RE.findall(fp.read()):
+                text = "".join(unescape(lit) for lit in LITERAL_RE.findall(literals))
+                if any(not 0 < ord(c) < RUN_CODE for c in text):
+                    raise ValueError(f"{name}: only ASCII characters other than NUL can be stored")
+                texts.append((name, text))
+
+    names = [name for name, _ in texts]
+    duplicates = sorted({name for name in names if names.count(name) > 1})
+    if duplicates:
+        raise ValueError(f"Duplicate texts: {', '.join(duplicates)}")
+    return texts
+
+
+def tokenize(text):
+    # Runs of RUN_MIN or more of one character become ("run", c, n) tokens,
+    # everything between them ("lit", s) tokens for the dictionary to work on.
+    tokens = []
+    for match in re.finditer(r"(.)\1*", text, re.DOTALL):
+        run = match.group(0)
+        if len(run) < RUN_MIN:
+            if tokens and tokens[-1][0] == "lit":
+                tokens[-1] = ("lit", tokens[-1][1] + run)
+            else:
+                tokens.append(("lit", run))
+            continue
+        while run:
+            n = min(len(run), RUN_MAX)
+            if n < RUN_MIN:
+                tokens.append(("lit", run[:n]))
+            else:
+                tokens.append(("run", run[0], n))
+            run = run[n:]
+    return tokens
+
+
+def literals(token_lists):
+    return [token[1] for tokens in token_lists for token in tokens if token[0] == "lit"]
+
+
+def best_entry(token_lists):
+    # Rank substrings by a quick overlapping count, then take the one that
+    # saves the most counted without overlaps. An entry costs its characters
+    # plus a two byte offset, and saves all but one byte per use.
+    segments = literals(token_lists)
+    counts = {}
+    for segment in segments:
+        for start in range(len(segment)):
+            for length in range(2, min(ENTRY_MAX, len(segment) - start) + 1):
+                sub = segment[start : start + length]
+                counts[sub] = counts.get(sub, 0) + 1
+
+    ranked = sorted(counts, key=lambda s: -(counts[s] * (len(s) - 1) - len(s) - 2))[:CANDIDATES]
+    best, best_saving = None, 0
+    for sub in ranked:
+        saving = sum(segment.count(sub) for segment in segments) * (len(sub) - 1) - len(sub) - 2
+        if saving > best_saving:
+            best, best_saving = sub, saving
+    return best
+
+
+def substitute(tokens, entry, index):
+    out = []
+    for token in tokens:
+        if token[0] != "lit":
+            out.append(token)
+            continue
+        parts = token[1].split(entry)
+        for i, part in enumerate(parts):
+            if i:
+                out.append(("dict", index))
+            if part:
+                out.append(("lit", part))
+    return out
+
+
+def compress(texts):
+    token_lists = [tokenize(text) for _, text in texts]
+    entries = []
+    while len(entries) < DICT_MAX:
+        entry = best_entry(token_lists)
+        if entry is None:
+            break
+        token_lists = [substitute(tokens, entry, len(entries)) for tokens in token_lists]
+        entries.append(entry)
+
+    encoded = []
+    for tokens in token_lists:
+        data = bytearray()
+        for token in tokens:
+            if token[0] == "lit":
+                data += token[1].encode()
+            elif token[0] == "run":
+                data += bytes([RUN_CODE + token[2] - RUN_MIN, ord(token[1])])
+            else:
+                data.append(DICT_CODE + token[1])
+        data.append(0)
+        encoded.append(bytes(data))
+    return entries, encoded
+
+
+def decode(data, entries):
+    out = []
+    i = 0
+    while data[i] != 0:
+        code = data[i]
+        if code < RUN_CODE:
+            out.append(chr(code))
+        elif code < DICT_CODE:
+            i += 1
+            out.append(chr(data[i]) * (code - RUN_CODE + RUN_MIN))
+        else:
+            out.append(entries[code - DICT_CODE])
+        i += 1
+    return "".join(out)
+
+
+def byte_lines(data):
+    return ["    " + " ".join(f"0x{b:02x}," for b in data[i : i + 12]) for i in range(0, len(data), 12)]
+
+
+def write_table(header_path, source_path, texts, sources):
+    entries, encoded = compress(texts)
+    for (name, text), data in zip(texts, encoded):
+        if decode(data, entries) != text:
+            raise RuntimeError(f"{name} does not decode to its text")
+
+    dictionary = "".join(entries).encode()
+    entry_offsets = [0]
+    for entry in entries:
+        entry_offsets.append(entry_offsets[-1] + len(entry))
+    text_offsets = [0]
+    for data in encoded:
+        text_offsets.append(text_offsets[-1] + len(data))
+
+    plain_size = sum(len(text) + 1 for _, text in texts)
+    table_size = len(dictionary) + 2 * len(entry_offsets) + text_offsets[-1] + 2 * len(texts)
+
+    banner = [
+        "// Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED",
+        "// Approved for public release. Distribution unlimited 23-02181-13.",
+        "",
+        f"// Generated by tools/gen_text.py from {', '.join(sources)}.",
+        "// Do not edit; change the .def files and rebuild.",
+        "",
+    ]
+
+    header = banner + [
+        "#ifndef TEXT_TABLE_H",
+        "#define TEXT_TABLE_H",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"#define TEXT_COUNT {len(texts)}",
+        f"#define TEXT_DICT_ENTRIES {len(entries)}",
+        "",
+    ]
+    for index, (name, _) in enumerate(texts):
+        header.append(f"#define TEXT_{name} {index}")
+    header += [
+        "",
+        f"// {plain_size} bytes of text stored in {table_size}",
+        f"#define TEXT_PLAIN_SIZE {plain_size}",
+        f"#define TEXT_TABLE_SIZE {table_size}",
+        "",
+        "extern const uint16_t text_offsets[TEXT_COUNT];",
+        "extern const uint16_t text_dict_offsets[TEXT_DICT_ENTRIES + 1];",
+        "extern const unsigned char text_dict[];",
+        "extern const unsigned char text_data[];",
+        "",
+        "#endif",
+        "",
+    ]
+
+    source = banner + [
+        '#include "text_table.h"',
+        "",
+        "const uint16_t text_offsets[TEXT_COUNT] = {",
+        "    " + ", ".join(str(offset) for offset in text_offsets[:-1]) + ",",
+        "};",
+        "",
+        "const uint16_t text_dict_offsets[TEXT_DICT_ENTRIES + 1] = {",
+    ]
+    for start in range(0, len(entry_offsets), 12):
+        source.append("    " + ", ".join(str(offset) for offset in entry_offsets[start : start + 12]) + ",")
+    source += [
+        "};",
+        "",
+        "const unsigned char text_dict[] = {",
+    ] + byte_lines(dictionary) + [
+        "};",
+        "",
+        "const unsigned char text_data[] = {",
+    ]
+    for (name, _), data in zip(texts, encoded):
+        source.append(f"    // {name}")
+        source += byte_lines(data)
+    source += [
+        "};",
+        "",
+    ]
+
+    with open(header_path, "w") as fp:
+        fp.write("\n".join(header))
+    with open(source_path, "w") as fp:
+        fp.write("\n".join(source))
+    return plain_size, table_size
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Diagnostics Shell Text Table Generator")
+    parser.add_argument("defs", help="TEXT(name, \"...\") definition files.", nargs="+")
+    parser.add_argument("--header", help="Header to write.", required=True)
+    parser.add_argument("--source", help="C source to write.", required=True)
+    args = parser.parse_args()
+
+    # Name the sources by their last two components, e.g. lib/text.def
+    sources = [os.path.join(*os.path.normpath(path).split(os.sep)[-2:]) for path in args.defs]
+    plain_size, table_size = write_table(args.header, args.source, read_texts(args.defs), sources)
+    print(f"Stored {plain_size} bytes of text in {table_size} bytes")
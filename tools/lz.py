@@ -0,0 +1,128 @@
+#!/usr/bin/env python
+
+# Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
+# Approved for public release. Distribution unlimited 23-02181-13.
+
+"""
+Small-Window LZSS Codec
+
+Matches bootloader/src/lz.c. The stream is a sequence of groups, each a flag
+byte followed by up to eight items, least significant flag bit first. A set
+bit is a literal byte. A clear bit is a match stored as a little-endian short
+with the distance minus one in the low 10 bits and the length minus three in
+the high 6 bits, so the decoder only needs a 1 KB history window.
+
+Run directly to print a compression ratio and throughput report:
+
+    python lz.py ../firmware/gcc/main.bin
+"""
+import argparse
+import time
+
+WINDOW_SIZE = 1024
+MIN_MATCH = 3
+MAX_MATCH = MIN_MATCH + 63
+MAX_CHAIN = 64
+
+
+def compress(data):
+    out = bytearray()
+    chains = {}  # 3-byte prefix -> recent positions, newest last
+    pos = 0
+    n = len(data)
+
+    while pos < n:
+        flag_index = len(out)
+        out.append(0)
+        flags = 0
+
+        for bit in range(8):
+            if pos >= n:
+                break
+
+            best_len = 0
+            best_dist = 0
+            if pos + MIN_MATCH <= n:
+                limit = min(MAX_MATCH, n - pos)
+                for cand in reversed(chains.get(data[pos : pos + MIN_MATCH], ())):
+                    dist = pos - cand
+                    if dist > WINDOW_SIZE:
+                        break
+                    length = MIN_MATCH
+                    while length < limit and data[cand + length] == data[pos + length]:
+                        length += 1
+                    if length > best_len:
+                        best_len, best_dist = length, dist
+                        if length == limit:
+                            break
+
+            if best_len >= MIN_MATCH:
+                token = ((best_len - MIN_MATCH) << 10) | (best_dist - 1)
+                out += token.to_bytes(2, "little")
+                step = best_len
+            else:
+                flags |= 1 << bit
+                out.append(data[pos])
+                step = 1
+
+            for p in range(pos, min(pos + step, n - MIN_MATCH + 1)):
+                chain = chains.setdefault(data[p : p + MIN_MATCH], [])
+                chain.append(p)
+                if len(chain) > MAX_CHAIN:
+                    del chain[0]
+            pos += step
+
+        out[flag_index] = flags
+
+    return bytes(out)
+
+
+def decompress(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        flags = data[i]
+        i += 1
+        for bit in range(8):
+            if i >= len(data):
+                break
+            if flags & (1 << bit):
+                out.append(data[i])
+                i += 1
+            else:
+                token = data[i] | (data[i + 1] << 8)
+                i += 2
+                dist = (token & 0x3FF) + 1
+                for _ in range((token >> 10) + MIN_MATCH):
+                    out.append(out[-dist])
+    return bytes(out)
+
+
+def report(path):
+    with open(path, "rb") as fp:
+        data = fp.read()
+
+    start = time.perf_counter()
+    packed = compress(data)
+    packed_time = time.perf_counter() - start
+
+    start = time.perf_counter()
+    unpacked = decompress(packed)
+    unpacked_time = time.perf_counter() - start
+
+    if unpacked != data:
+        raise RuntimeError("ERROR: Round trip mismatch")
+
+    print(f"Input:       {len(data)} bytes")
+    print(f"Compressed:  {len(packed)} bytes ({100.0 * len(packed) / max(len(data), 1):.1f}%)")
+    print(f"Ratio:       {len(data) / max(len(packed), 1):.2f}:1")
+    print(f"Compress:    {len(data) / packed_time / 1024:.1f} KB/s (host)")
+    print(f"Decompress:  {len(data) / unpacked_time / 1024:.1f} KB/s (host, Python)")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="LZSS Compression Report")
+    parser.add_argument("infile", help="Path to the firmware binary.")
+    args = parser.parse_args()
+
+    report(args.infile)
@@ -3,40 +3,168 @@
 # Copyright 2023 The MITRE Corporation. ALL RIGHTS RESERVED
 # Approved for public release. Distribution unlimited 23-02181-13.
 
+import os
+import select
 import socket
 
 UART0_PATH = "/embsec/UART0"
 UART1_PATH = "/embsec/UART1"
 UART2_PATH = "/embsec/UART2"
 
+
+def uart_paths(socket_dir=None):
+    # The three UART sockets of one emulator. Each emulated device in a fleet
+    # gets its own directory; without one it is the usual /embsec set.
+    if socket_dir is None:
+        return [UART0_PATH, UART1_PATH, UART2_PATH]
+    return [os.path.join(socket_dir, f"UART{i}") for i in range(3)]
+
+
+RECV_BUFFER_SIZE = 4096
+SMALL_WRITE_SIZE = 256
+
+
 class DomainSocketSerial:
+    # A buffered transport over the emulator's UART socket. Received bytes
+    # land in one preallocated buffer (recv_into) and are handed out from it,
+    # so reads are exact however the kernel splits the stream, and a byte at
+    # a time costs no system call. Writes always go out whole.
     def __init__(self, ser_socket: socket.socket):
         self.ser_socket = ser_socket
-    
+        self._baudrate = 115200
+        self._buffer = bytearray(RECV_BUFFER_SIZE)
+        self._view = memoryview(self._buffer)
+        self._start = 0  # first unread byte
+        self._end = 0  # end of the received bytes
+
+    # pyserial style line settings, so tools can drive either transport.
+    @property
+    def timeout(self):
+        return self.ser_socket.gettimeout()
+
+    @timeout.setter
+    def timeout(self, value):
+        self.ser_socket.settimeout(value)
+
+    @property
+    def baudrate(self):
+        return self._baudrate
+
+    @baudrate.setter
+    def baudrate(self, value):
+        # A domain socket has no line rate: QEMU's UART model does not pace
+        # its chardev by the programmed divisor, so this is only recorded.
+        self._baudrate = value
+
+    @property
+    def in_waiting(self):
+        return self._end - self._start
+
+    def _fill(self):
+        # Receive more into the buffer, moving the unread bytes to the front
+        # first if they would not leave room. Raises socket.timeout if nothing
+        # arrives within the timeout, and ConnectionError on end of stream.
+        if self._start == self._end:
+            self._start = self._end = 0
+        elif self._end == len(self._buffer):
+            unread = self._end - self._start
+            self._buffer[:unread] = self._view[self._start : self._end]
+            self._start, self._end = 0, unread
+
+        received = self.ser_socket.recv_into(self._view[self._end :])
+        if not received:
+            raise ConnectionError("Connection closed by the device")
+        self._end += received
+
     def read(self, length: int) -> bytes:
+        # Exactly length bytes. On a timeout the bytes received so far stay
+        # buffered for the next read.
+        start = self._start
+        end = start + length
+        if length > 0 and end <= self._end:
+            self._start = end
+            return bytes(self._buffer[start:end])
+
         if length < 1:
             raise ValueError("Read length must be at least 1 byte")
-        
-        return self.ser_socket.recv(length)
-    
-    def readline(self) -> bytes:
-        line = b""
+        if length > len(self._buffer):
+            return b"".join(self.read(min(length - i, len(self._buffer))) for i in range(0, length, len(self._buffer)))
+
+        while self._end - self._start < length:
+            self._fill()
+        return self.read(length)
 
-        c = self.ser_socket.recv(1)
-        while c != b"\n":
-            line += c
-            c = self.ser_socket.recv(1)
-        
-        line += b'\n'
-        return line
+    def readline(self) -> bytes:
+        checked = 0  # unread bytes already searched for the newline
+        while True:
+            newline = self._buffer.find(b"\n", self._start + checked, self._end)
+            if newline >= 0:
+                return self.read(newline + 1 - self._start)
+            checked = self._end - self._start
+            if checked == len(self._buffer):
+                # A line longer than the buffer: hand it out in pieces.
+                return self.read(checked) + self.readline()
+            self._fill()
 
     def write(self, data: bytes):
-        self.ser_socket.send(data)
+        self.ser_socket.sendall(data)
+
+    def writev(self, buffers):
+        # Write several buffers as one, e.g. a frame header and a memoryview
+        # of the payload. Small writes are cheaper joined than gathered.
+        total = sum(map(len, buffers))
+        if total <= SMALL_WRITE_SIZE:
+            self.ser_socket.sendall(b"".join(buffers))
+            return
+
+        sent = self.ser_socket.sendmsg(buffers)
+        if sent == total:
+            return
+        views = [memoryview(b).cast("B") for b in buffers if len(b)]
+        while views:
+            while views and sent >= len(views[0]):
+                sent -= len(views.pop(0))
+            if sent:
+                views[0] = views[0][sent:]
+            if views:
+                sent = self.ser_socket.sendmsg(views)
+
+    def sendfile(self, file, offset, count):
+        # Write count bytes of an open file straight from the page cache.
+        # socket.sendfile() sets up a selector on every call, which costs
+        # more than the copy it saves for a window of frames.
+        out_fd = self.ser_socket.fileno()
+        while count:
+            try:
+                sent = os.sendfile(out_fd, file.fileno(), offset, count)
+            except BlockingIOError:
+                # A socket with a timeout is non-blocking underneath.
+                if not select.select([], [out_fd], [], self.timeout)[1]:
+                    raise socket.timeout("Timed out writing to the device")
+                continue
+            if not sent:
+                raise ConnectionError("Connection closed by the device")
+            offset += sent
+            count -= sent
+
+    def flush_input(self):
+        # Discard anything already received, e.g. after the device reset.
+        self._start = self._end = 0
+        timeout = self.ser_socket.gettimeout()
+        self.ser_socket.setblocking(False)
+        try:
+            while self.ser_socket.recv_into(self._view):
+                pass
+        except BlockingIOError:
+            pass
+        finally:
+            self.ser_socket.settimeout(timeout)
 
     def close(self):
         self.ser_socket.close()
         del self
 
+
 def print_hex(data):
     hex_string = ' '.join(format(byte, '02x') for byte in data)
     print(hex_string)
\ No newline at end of file